@@ -0,0 +1,535 @@
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <functional>
+
+#include "wrapidjson/document.h"
+#include "wrapidjson/document_pool.h"
+#include "wrapidjson/small_document.h"
+#include "wrapidjson/snapshot.h"
+#include "wrapidjson/push_parser.h"
+#include "wrapidjson/line_reader.h"
+#include "wrapidjson/sax.h"
+
+using namespace wrapidjson;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// count heap allocations ( glibc only )
+/////////////////////////////////////////////////////////////////////////////////////////////
+static std::atomic<size_t> malloc_count(0);
+
+#if defined(__GLIBC__)
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size) noexcept { ++malloc_count; return __libc_malloc(size); }
+void* calloc(size_t count, size_t size) noexcept { ++malloc_count; return __libc_calloc(count, size); }
+void* realloc(void* ptr, size_t size) noexcept { ++malloc_count; return __libc_realloc(ptr, size); }
+}
+#endif
+
+namespace {
+
+/// run function( ) repeat times, print the best throughput
+void measure(const std::string& name, size_t bytes, int repeat, const std::function<void()>& function)
+{
+    double best = 0;
+    for (int i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        if (best == 0 or elapsed.count() < best) {
+            best = elapsed.count();
+        }
+    }
+    std::printf("%-40s %10.3f ms %10.1f MB/s\n", name.c_str(), best * 1000, bytes / best / (1 << 20));
+}
+
+std::string make_ndjson(size_t bytes)
+{
+    std::string lines;
+    lines.reserve(bytes + 256);
+    for (size_t i = 0; lines.size() < bytes; ++i) {
+        lines += R"({"id":)" + std::to_string(i)
+            + R"(,"name":"record-)" + std::to_string(i)
+            + R"(","score":)" + std::to_string(i * 0.25)
+            + R"(,"tags":["a","b","c"],"nested":{"ok":true,"values":[1,2,3,4,5]}})" + "\n";
+    }
+    return lines;
+}
+
+void bench_ndjson()
+{
+    std::string lines = make_ndjson(64 << 20);
+    std::printf("== NDJSON parse ( %zu MB )\n", lines.size() >> 20);
+
+    measure("LineReader", lines.size(), 3, [&]() {
+        size_t count = 0;
+        LineReader reader;
+        reader.open_buffer(lines);
+        while (reader.next()) {
+            count += reader.valid();
+        }
+    });
+
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2) {
+        measure("ParallelLineReader threads=" + std::to_string(threads), lines.size(), 3, [&]() {
+            std::atomic<size_t> count(0);
+            ParallelLineReader reader(threads);
+            reader.read_buffer(lines, [&](size_t, ValueRef) { ++count; });
+        });
+        measure("ParallelLineReader ordered threads=" + std::to_string(threads), lines.size(), 3, [&]() {
+            size_t count = 0;
+            ParallelLineReader reader(threads, true);
+            reader.read_buffer(lines, [&](size_t, ValueRef) { ++count; });
+        });
+    }
+}
+
+std::string make_array(size_t bytes)
+{
+    std::string json = make_ndjson(bytes);
+    for (auto& c : json) {
+        if (c == '\n') {
+            c = ',';
+        }
+    }
+    json.back() = ']';
+    return "[" + json;
+}
+
+void bench_stream()
+{
+    std::string json = make_array(64 << 20);
+    const std::string path = "wrapidjson_bench_stream.json";
+    {
+        std::ofstream ofs(path);
+        ofs << json;
+    }
+    std::printf("== stream parse ( %zu MB )\n", json.size() >> 20);
+    measure("load_from_buffer", json.size(), 3, [&]() {
+        Document doc;
+        doc.load_from_buffer(string_view(json));
+    });
+    measure("load_from_stream ( istringstream )", json.size(), 3, [&]() {
+        std::istringstream is(json);
+        Document doc;
+        doc.load_from_stream(is);
+    });
+    measure("load_from_stream ( ifstream )", json.size(), 3, [&]() {
+        std::ifstream is(path);
+        Document doc;
+        doc.load_from_stream(is);
+    });
+    measure("load_from_file", json.size(), 3, [&]() {
+        Document doc;
+        doc.load_from_file(path);
+    });
+    std::remove(path.c_str());
+}
+
+void bench_sax()
+{
+    std::string json = make_array(64 << 20);
+    std::printf("== DOM vs SAX ( %zu MB )\n", json.size() >> 20);
+
+    measure("Document::load_from_buffer", json.size(), 3, [&]() {
+        Document doc;
+        doc.load_from_buffer(string_view(json));
+    });
+
+    struct Counter : SaxHandler {
+        bool on_int64(int64_t) { ++numbers; return true; }
+        bool on_double(double) { ++numbers; return true; }
+        size_t numbers = 0;
+    };
+    measure("SaxReader::load_from_buffer", json.size(), 3, [&]() {
+        Counter counter;
+        SaxReader reader;
+        reader.load_from_buffer(json, counter);
+    });
+}
+
+void bench_projection()
+{
+    // wide records, a few fields read
+    std::string record = "{";
+    for (int i = 0; i < 300; ++i) {
+        record += R"("field)" + std::to_string(i) + R"(":{"name":"value)" + std::to_string(i) + R"(","list":[1,2,3]},)";
+    }
+    record += R"("id":42})";
+    std::printf("== projection ( %zu bytes x 10000 )\n", record.size());
+
+    measure("Document::load_from_buffer", record.size() * 10000, 3, [&]() {
+        for (int i = 0; i < 10000; ++i) {
+            Document doc;
+            doc.load_from_buffer(string_view(record));
+        }
+    });
+    Projection projection{"/id", "/field10/name", "/field200/list"};
+    measure("Document::load_from_buffer projection", record.size() * 10000, 3, [&]() {
+        for (int i = 0; i < 10000; ++i) {
+            Document doc;
+            doc.load_from_buffer(record, projection);
+        }
+    });
+}
+
+void bench_lazy()
+{
+    std::string json = "{";
+    for (int i = 0; i < 1000; ++i) {
+        json += R"("section)" + std::to_string(i) + R"(":)" + make_array(8 << 10) + ",";
+    }
+    json.back() = '}';
+    std::printf("== lazy document ( %zu MB, one section read )\n", json.size() >> 20);
+
+    measure("Document::load_from_buffer", json.size(), 3, [&]() {
+        Document doc;
+        doc.load_from_buffer(string_view(json));
+        doc["section500"].get_array()[3]["name"].as<std::string>();
+    });
+    measure("LazyDocument::load_from_buffer", json.size(), 3, [&]() {
+        LazyDocument doc;
+        doc.load_from_buffer(string_view(json));
+        doc.find_pointer("/section500/3/name")->as<std::string>();
+    });
+}
+
+template <typename Doc>
+void measure_parse(const std::string& name, const std::string& json)
+{
+    measure(name, json.size(), 3, [&]() {
+        Doc doc;
+        doc.load_from_buffer(json);
+    });
+}
+
+void bench_flags()
+{
+    Document source;
+    source.load_from_buffer(make_array(32 << 20));
+    std::string compact, pretty;
+    source.save_to_buffer(compact);
+    source.save_to_buffer(pretty, true);
+#if defined(RAPIDJSON_SSE42)
+    const char* simd = "SSE4.2";
+#elif defined(RAPIDJSON_SSE2)
+    const char* simd = "SSE2";
+#else
+    const char* simd = "none";
+#endif
+    std::printf("== parse flags ( %zu MB, SIMD %s )\n", compact.size() >> 20, simd);
+
+    for (const std::string* json : {&compact, &pretty}) {
+        const std::string suffix = json == &compact ? "" : " pretty";
+        measure_parse<Document>("default" + suffix, *json);
+        measure_parse<BasicDocument<rapidjson::kParseIterativeFlag>>("iterative" + suffix, *json);
+        measure_parse<BasicDocument<rapidjson::kParseFullPrecisionFlag>>("full precision" + suffix, *json);
+        measure_parse<BasicDocument<rapidjson::kParseValidateEncodingFlag>>("validate encoding" + suffix, *json);
+        measure_parse<BasicDocument<rapidjson::kParseNanAndInfFlag>>("nan and inf" + suffix, *json);
+    }
+}
+
+void bench_reset()
+{
+    std::string json = make_array(64 << 10);
+    const int requests = 10000;
+    std::printf("== document reuse ( %zu KB x %d )\n", json.size() >> 10, requests);
+
+    size_t count = malloc_count;
+    measure("new Document per request", json.size() * requests, 1, [&]() {
+        for (int i = 0; i < requests; ++i) {
+            Document doc;
+            doc.load_from_buffer(string_view(json));
+        }
+    });
+    std::printf("%-40s %10.1f mallocs per request\n", "", double(malloc_count - count) / requests);
+
+    Document doc;
+    count = malloc_count;
+    measure("Document::reset per request", json.size() * requests, 1, [&]() {
+        for (int i = 0; i < requests; ++i) {
+            doc.reset();
+            doc.load_from_buffer(string_view(json));
+        }
+    });
+    std::printf("%-40s %10.1f mallocs per request\n", "", double(malloc_count - count) / requests);
+
+    unsigned max_threads = std::max(1u, std::thread::hardware_concurrency());
+    DocumentPool pool(max_threads);
+    pool.prewarm(max_threads);
+    count = malloc_count;
+    measure("DocumentPool threads=" + std::to_string(max_threads), json.size() * requests, 1, [&]() {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < max_threads; ++t) {
+            threads.emplace_back([&]() {
+                for (int i = 0; i < requests / int(max_threads); ++i) {
+                    auto doc = pool.acquire();
+                    doc->load_from_buffer(string_view(json));
+                }
+            });
+        }
+        for (auto& thread : threads) {
+            thread.join();
+        }
+    });
+    std::printf("%-40s %10.1f mallocs per request\n", "", double(malloc_count - count) / requests);
+}
+
+void bench_small()
+{
+    const std::string json = R"({"id":12345,"user":"alice","tags":["a","b","c"],"geo":{"lat":37.5,"lon":127.0},"ok":true})";
+    const int requests = 200000;
+    std::printf("== small messages ( %zu B x %d )\n", json.size(), requests);
+
+    std::string out;
+    out.reserve(json.size() * 2);
+    size_t count = malloc_count;
+    measure("Document per message", json.size() * requests, 1, [&]() {
+        for (int i = 0; i < requests; ++i) {
+            Document doc;
+            doc.load_from_buffer(string_view(json));
+            doc.save_to_buffer(out);
+        }
+    });
+    std::printf("%-40s %10.1f mallocs per message\n", "", double(malloc_count - count) / requests);
+
+    count = malloc_count;
+    measure("SmallDocument<> per message", json.size() * requests, 1, [&]() {
+        for (int i = 0; i < requests; ++i) {
+            SmallDocument<> doc;
+            doc.load_from_buffer(string_view(json));
+            doc.save_to_buffer(out);
+        }
+    });
+    std::printf("%-40s %10.1f mallocs per message\n", "", double(malloc_count - count) / requests);
+}
+
+void bench_compressed()
+{
+#ifdef WRAPIDJSON_ZLIB
+    std::string json = make_array(32 << 20);
+    const std::string path = "json_bench_compressed.json.gz";
+    Document source;
+    source.load_from_buffer(string_view(json));
+    source.save_to_file(path, false, Compression::gzip);
+    std::printf("== gzip file ( %zu MB json )\n", json.size() >> 20);
+
+    measure("gunzip to string + load_from_buffer", json.size(), 3, [&]() {
+        std::string buffer;
+        detail::GzipFile file(path, "rb");
+        char chunk[65536];
+        size_t n = 0;
+        while ((n = file.read(chunk, sizeof(chunk))) > 0) {
+            buffer.append(chunk, n);
+        }
+        Document doc;
+        doc.load_from_buffer(buffer);
+    });
+    measure("load_from_file ( streaming )", json.size(), 3, [&]() {
+        Document doc;
+        doc.load_from_file(path, Compression::gzip);
+    });
+    measure("save_to_file ( streaming )", json.size(), 3, [&]() {
+        source.save_to_file(path, false, Compression::gzip);
+    });
+    std::remove(path.c_str());
+#endif
+}
+
+void bench_binary()
+{
+    std::string json = make_array(32 << 20);
+    Document doc;
+    doc.load_from_buffer(string_view(json));
+    std::string text;
+    std::string msgpack;
+    std::string cbor;
+    doc.save_to_buffer(text);
+    doc.save_to_msgpack(msgpack);
+    doc.save_to_cbor(cbor);
+    std::printf("== binary encodings ( json %zu KB, msgpack %zu KB, cbor %zu KB )\n",
+            text.size() >> 10, msgpack.size() >> 10, cbor.size() >> 10);
+
+    measure("json save_to_buffer", text.size(), 3, [&]() { doc.save_to_buffer(text); });
+    measure("save_to_msgpack", text.size(), 3, [&]() { doc.save_to_msgpack(msgpack); });
+    measure("save_to_cbor", text.size(), 3, [&]() { doc.save_to_cbor(cbor); });
+    measure("json load_from_buffer", text.size(), 3, [&]() {
+        Document loaded;
+        loaded.load_from_buffer(string_view(text));
+    });
+    measure("load_from_msgpack", text.size(), 3, [&]() {
+        Document loaded;
+        loaded.load_from_msgpack(msgpack);
+    });
+    measure("load_from_cbor", text.size(), 3, [&]() {
+        Document loaded;
+        loaded.load_from_cbor(cbor);
+    });
+}
+
+void bench_snapshot()
+{
+    std::string json = make_array(64 << 20);
+    Document source;
+    source.load_from_buffer(string_view(json));
+    const std::string json_path = "json_bench_snapshot.json";
+    const std::string path = "json_bench_snapshot.snap";
+    source.save_to_file(json_path);
+    std::printf("== snapshot ( %zu records, open and read one record )\n", source.size());
+
+    measure("save_snapshot", json.size(), 3, [&]() { source.save_snapshot(path); });
+    measure("load_from_mmap + lookup", json.size(), 3, [&]() {
+        Document doc;
+        doc.load_from_mmap(json_path);
+        doc[source.size() / 2]["name"].as<std::string>();
+    });
+    measure("SnapshotDocument + lookup", json.size(), 3, [&]() {
+        SnapshotDocument doc;
+        doc.load_from_file(path);
+        doc[source.size() / 2]["name"].as<std::string>();
+    });
+    std::remove(json_path.c_str());
+    std::remove(path.c_str());
+}
+
+void bench_push()
+{
+    std::string json = make_array(64 << 20);
+    std::printf("== push parser ( %zu MB in 64 KB chunks )\n", json.size() >> 20);
+
+    measure("load_from_buffer", json.size(), 3, [&]() {
+        Document doc;
+        doc.load_from_buffer(string_view(json));
+    });
+    measure("PushParser::feed", json.size(), 3, [&]() {
+        Document doc;
+        PushParser parser(doc);
+        for (size_t i = 0; i < json.size(); i += 65536) {
+            parser.feed(json.data() + i, std::min<size_t>(65536, json.size() - i));
+        }
+        parser.finish();
+    });
+}
+
+void bench_segments()
+{
+    std::string json = make_array(64 << 20);
+    std::vector<string_view> segments;
+    for (size_t i = 0; i < json.size(); i += 1448) {
+        segments.push_back(string_view(json.data() + i, std::min<size_t>(1448, json.size() - i)));
+    }
+    std::printf("== scattered input ( %zu MB in %zu segments )\n", json.size() >> 20, segments.size());
+
+    measure("gather + load_from_buffer", json.size(), 3, [&]() {
+        std::string gathered;
+        for (const auto& segment : segments) {
+            gathered.append(segment.data(), segment.size());
+        }
+        Document doc;
+        doc.load_from_buffer(string_view(gathered));
+    });
+    measure("load_from_segments", json.size(), 3, [&]() {
+        Document doc;
+        doc.load_from_segments(segments);
+    });
+}
+
+void bench_parse_into()
+{
+    const std::string json = R"({"id":12345,"name":"record","tags":["a","b","c"],"score":0.5})";
+    const size_t count = 100000;
+    std::printf("== parse into a member ( %zu times )\n", count);
+
+    measure("root[\"e\"] = Document(json)", json.size() * count, 3, [&]() {
+        Document root;
+        for (size_t i = 0; i < count; ++i) {
+            root["e"] = Document(json);
+        }
+    });
+    measure("root[\"e\"].parse(json)", json.size() * count, 3, [&]() {
+        Document root;
+        for (size_t i = 0; i < count; ++i) {
+            root["e"].parse(json);
+        }
+    });
+}
+
+void bench_move()
+{
+    std::string json = make_array(32 << 20);
+    std::printf("== regroup records into a new array ( %zu MB )\n", json.size() >> 20);
+
+    measure("push_back ( copy )", json.size(), 3, [&]() {
+        Document doc;
+        doc.load_from_buffer(string_view(json));
+        Document grouped;
+        auto array = grouped.set_array();
+        for (auto record : doc.get_array()) {
+            array.push_back(record);
+        }
+    });
+    measure("push_back ( take )", json.size(), 3, [&]() {
+        Document doc;
+        doc.load_from_buffer(string_view(json));
+        Document grouped(doc.get_document().GetAllocator());
+        auto array = grouped.set_array();
+        for (auto record : doc.get_array()) {
+            array.push_back(record.take());
+        }
+    });
+}
+
+void bench_to_string()
+{
+    std::string json = make_array(32 << 20);
+    Document doc;
+    doc.load_from_buffer(string_view(json));
+    std::printf("== ValueRef serialization ( %zu records )\n", doc.size());
+
+    std::string out;
+    measure("Document(record).save_to_buffer", json.size(), 3, [&]() {
+        for (auto record : doc.get_array()) {
+            Document copy(record);
+            copy.save_to_buffer(out);
+        }
+    });
+    measure("record.to_string(out)", json.size(), 3, [&]() {
+        for (auto record : doc.get_array()) {
+            record.to_string(out);
+        }
+    });
+}
+
+} // namespace
+
+int main()
+{
+    bench_stream();
+    bench_ndjson();
+    bench_sax();
+    bench_projection();
+    bench_lazy();
+    bench_flags();
+    bench_reset();
+    bench_small();
+    bench_compressed();
+    bench_binary();
+    bench_snapshot();
+    bench_push();
+    bench_segments();
+    bench_parse_into();
+    bench_move();
+    bench_to_string();
+    return 0;
+}
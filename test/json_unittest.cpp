@@ -1,4 +1,10 @@
 #include <string>
+#include <fstream>
+#include <sstream>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <cstdio>
 #include <list>
 #include <map>
 #include <set>
@@ -8,6 +14,13 @@
 #include <gtest/gtest.h>
 
 #include "wrapidjson/document.h"
+#include "wrapidjson/document_pool.h"
+#include "wrapidjson/small_document.h"
+#include "wrapidjson/snapshot.h"
+#include "wrapidjson/push_parser.h"
+#include "wrapidjson/line_reader.h"
+#include "wrapidjson/line_writer.h"
+#include "wrapidjson/sax.h"
 
 using namespace wrapidjson;
 
@@ -643,3 +656,1137 @@ TEST(wrapidjsonTest, find_test)
     EXPECT_TRUE(root.find_all(std::vector<std::string>{"TEST2"}));
     EXPECT_FALSE(root.find_all(std::vector<std::string>{"TEST2", "TEST3"}));
 }
+
+TEST(wrapidjsonTest, load_from_mmap)
+{
+    const std::string path = "wrapidjson_mmap_test.json";
+    {
+        std::ofstream ofs(path);
+        ofs << R"({"a":"plain","b":"esc\"aped\u0041","c":[1,2.5,-3],"d":{"e":true}})";
+    }
+
+    Document doc;
+    EXPECT_TRUE(doc.load_from_mmap(path));
+    EXPECT_EQ(doc["a"].as<std::string>(), "plain");
+    EXPECT_EQ(doc["b"].as<std::string>(), "esc\"apedA");
+    EXPECT_EQ(doc["c"].get_array().as_vector<double>(), (std::vector<double>{1, 2.5, -3}));
+    EXPECT_TRUE(*doc["d"]["e"].get<bool>());
+
+    std::string res;
+    doc.save_to_buffer(res);
+    EXPECT_EQ(res, R"({"a":"plain","b":"esc\"apedA","c":[1,2.5,-3],"d":{"e":true}})");
+
+    // copies own their strings and keys, they outlive the mapping
+    std::unique_ptr<Document> source(new Document());
+    EXPECT_TRUE(source->load_from_mmap(path));
+    Document copy((*source)["d"]);
+    Document other;
+    other["k"] = (*source)["a"];
+    other["arr"].push_back((*source)["b"]);
+    source.reset();
+    EXPECT_EQ(copy.to_string(), R"({"e":true})");
+    EXPECT_EQ(other.to_string(), R"({"k":"plain","arr":["esc\"apedA"]})");
+
+    const std::string broken = "wrapidjson_mmap_broken.json";
+    {
+        std::ofstream ofs(broken);
+        ofs << R"({"a":)";
+    }
+    EXPECT_FALSE(doc.load_from_mmap(broken));
+    EXPECT_EQ(doc["a"].as<std::string>(), "plain"); // previous mapping is still alive
+
+    std::remove(broken.c_str());
+    EXPECT_FALSE(doc.load_from_mmap(broken));
+    std::remove(path.c_str());
+}
+
+TEST(wrapidjsonTest, load_from_buffer_insitu)
+{
+    std::string json = R"({"a":"moved","b":["x\ty",1]})";
+    Document doc;
+    EXPECT_TRUE(doc.load_from_buffer_insitu(std::move(json)));
+    EXPECT_EQ(doc["a"].as<std::string>(), "moved");
+    EXPECT_EQ(doc["b"].get_array()[0].as<std::string>(), "x\ty");
+    EXPECT_EQ(doc["b"][1].as<int>(), 1);
+
+    std::string res;
+    doc.save_to_buffer(res);
+    EXPECT_EQ(res, R"({"a":"moved","b":["x\ty",1]})");
+
+    std::vector<char> raw = {'[', '"', 'r', 'a', 'w', '"', ']', ' ', 'x'};
+    EXPECT_TRUE(doc.load_from_buffer_insitu(raw.data(), 8));   // trailing 'x' is outside of the buffer
+    EXPECT_EQ(doc.get_array()[0].as<std::string>(), "raw");
+    EXPECT_FALSE(doc.load_from_buffer_insitu(raw.data(), raw.size()));
+
+    EXPECT_FALSE(doc.load_from_buffer_insitu(std::string(R"({"a":)")));
+
+    // temporaries keep the copying parse
+    EXPECT_TRUE(doc.load_from_buffer(std::string(R"({"a":"copied"})")));
+    EXPECT_EQ(doc["a"].as<std::string>(), "copied");
+}
+
+TEST(wrapidjsonTest, load_from_string_view)
+{
+    std::string packet = R"({"a":1,"b":"view"}{"garbage")";
+    Document doc;
+    EXPECT_TRUE(doc.load_from_buffer(string_view(packet.data(), 18)));
+    EXPECT_EQ(doc["a"].as<int>(), 1);
+    EXPECT_EQ(doc["b"].as<std::string>(), "view");
+
+    EXPECT_FALSE(doc.load_from_buffer(string_view(packet.data(), 19)));
+    EXPECT_EQ(doc.get_load_error(), "Error offset[18]: The document root must not be followed by other values.");
+
+    EXPECT_FALSE(doc.load_from_buffer(string_view(packet.data(), 17)));
+    EXPECT_TRUE(doc.load_from_buffer(R"([1,2,3])"));
+    EXPECT_EQ(doc.size(), 3u);
+}
+
+TEST(wrapidjsonTest, load_from_stream_buffered)
+{
+    std::string json = "[";
+    for (int i = 0; i < 20000; ++i) {
+        json += std::to_string(i) + ",";
+    }
+    json += "\"end\"]";
+
+    std::stringstream ss(json);
+    Document doc;
+    EXPECT_TRUE(doc.load_from_stream(ss));
+    EXPECT_EQ(doc.size(), 20001u);
+    EXPECT_EQ(doc.get_array()[19999].as<int>(), 19999);
+    EXPECT_EQ(doc.get_array().back().as<std::string>(), "end");
+
+    std::stringstream broken(json.substr(0, json.size() - 1));
+    EXPECT_FALSE(doc.load_from_stream(broken));
+    EXPECT_EQ(doc.get_load_error(), detail::format("Error offset[%u]: Missing a comma or ']' after an array element.",
+                (unsigned)json.size() - 1));
+
+    // unread bytes are given back to the stream
+    std::stringstream rest("[1,2] rest");
+    {
+        IStream is(rest, 4);
+        doc.get_document().ParseStream<rapidjson::kParseStopWhenDoneFlag>(is);
+        EXPECT_FALSE(doc.get_document().HasParseError());
+        EXPECT_EQ(is.Tell(), 5u);
+    }
+    std::string tail;
+    std::getline(rest, tail);
+    EXPECT_EQ(tail, " rest");
+
+    // a pipe like streambuf ( not seekable, delivers pieces ) is not read past the document
+    struct PieceBuf : std::streambuf {
+        std::vector<std::string> pieces;
+        size_t next = 0;
+        int_type underflow() override {
+            if (next == pieces.size()) {
+                return traits_type::eof();
+            }
+            std::string& piece = pieces[next++];
+            setg(&piece[0], &piece[0], &piece[0] + piece.size());
+            return traits_type::to_int_type(piece[0]);
+        }
+    } pipe;
+    pipe.pieces = { R"({"a":)", "1}", R"({"b":2})" };
+    std::istream pipe_stream(&pipe);
+    BasicDocument<rapidjson::kParseStopWhenDoneFlag> first;
+    EXPECT_TRUE(first.load_from_stream(pipe_stream));
+    EXPECT_EQ(first.to_string(), R"({"a":1})");
+    EXPECT_EQ(pipe.next, 2u);   // the next message was not waited for
+    BasicDocument<rapidjson::kParseStopWhenDoneFlag> second;
+    EXPECT_TRUE(second.load_from_stream(pipe_stream));
+    EXPECT_EQ(second.to_string(), R"({"b":2})");
+}
+
+TEST(wrapidjsonTest, save_to_stream_chunked)
+{
+    Document doc;
+    for (int i = 0; i < 1000; ++i) {
+        doc[std::to_string(i)] = std::vector<int>{i, i + 1, i + 2};
+    }
+
+    std::string expected;
+    EXPECT_TRUE(doc.save_to_buffer(expected));
+
+    std::stringstream out;
+    EXPECT_TRUE(doc.save_to_stream(out, false, 7));
+    EXPECT_EQ(out.str(), expected);
+
+    std::stringstream pretty;
+    EXPECT_TRUE(doc.save_to_stream(pretty, true));
+    Document reload;
+    EXPECT_TRUE(reload.load_from_stream(pretty));
+    EXPECT_EQ(reload.size(), 1000u);
+
+    std::ostream broken(nullptr);
+    EXPECT_FALSE(doc.save_to_stream(broken));
+}
+
+TEST(wrapidjsonTest, save_to_buffer_reuse)
+{
+    Document doc(R"({"a":[1,2,3],"b":"text"})");
+
+    std::string buffer;
+    buffer.reserve(1024);
+    const char* data = buffer.data();
+    EXPECT_TRUE(doc.save_to_buffer(buffer));
+    EXPECT_EQ(buffer, R"({"a":[1,2,3],"b":"text"})");
+    EXPECT_TRUE(doc.save_to_buffer(buffer));
+    EXPECT_EQ(buffer, R"({"a":[1,2,3],"b":"text"})");
+    EXPECT_EQ(buffer.data(), data);
+
+    std::vector<char> vec;
+    EXPECT_TRUE(doc.save_to_buffer(vec));
+    EXPECT_EQ(std::string(vec.begin(), vec.end()), buffer);
+
+    // a failed save leaves the buffer empty ( no partial document )
+    Document nan;
+    nan["x"] = std::numeric_limits<double>::quiet_NaN();
+    EXPECT_FALSE(nan.save_to_buffer(buffer));
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_FALSE(nan.save_to_buffer(vec));
+    EXPECT_TRUE(vec.empty());
+}
+
+TEST(wrapidjsonTest, line_reader)
+{
+    std::string lines = "{\"id\":1,\"name\":\"first\"}\n"
+                        "\n"
+                        "{\"id\":2,\"name\":\"second\"}\r\n"
+                        "{\"id\":3,\"name\":}\n"
+                        "[4]";
+
+    auto check = [](LineReader& reader) {
+        std::vector<int> ids;
+        std::vector<size_t> bad_lines;
+        while (reader.next()) {
+            if (not reader.valid()) {
+                bad_lines.push_back(reader.line());
+                continue;
+            }
+            ValueRef record = reader.value();
+            ids.push_back(record.is_array() ? record.get_array()[0].as<int>() : record["id"].as<int>());
+        }
+        EXPECT_EQ(ids, (std::vector<int>{1, 2, 4}));
+        EXPECT_EQ(bad_lines, (std::vector<size_t>{4}));
+    };
+
+    LineReader reader;
+    reader.open_buffer(lines);
+    EXPECT_TRUE(reader.next());
+    EXPECT_EQ(reader.line(), 1u);
+    EXPECT_EQ(reader.value()["name"].as<std::string>(), "first");
+    EXPECT_TRUE(reader.next());
+    EXPECT_EQ(reader.line(), 3u);
+    EXPECT_TRUE(reader.next());
+    EXPECT_FALSE(reader.valid());
+    EXPECT_EQ(reader.get_load_error(), "Error line[4] offset[15]: Invalid value.");
+
+    reader.open_buffer(lines);
+    check(reader);
+
+    std::stringstream ss(lines);
+    reader.open_stream(ss);
+    check(reader);
+
+    const std::string path = "wrapidjson_line_reader.json";
+    {
+        std::ofstream ofs(path);
+        ofs << lines;
+    }
+    EXPECT_TRUE(reader.open_file(path));
+    check(reader);
+    std::remove(path.c_str());
+    EXPECT_FALSE(reader.open_file(path));
+}
+
+TEST(wrapidjsonTest, line_writer)
+{
+    const std::string path = "wrapidjson_line_writer.json";
+    {
+        LineWriter writer(64);
+        EXPECT_TRUE(writer.write(Document(R"({"id":0})")));
+        EXPECT_FALSE(writer.flush());               // no output yet
+        EXPECT_FALSE(writer.good());
+        EXPECT_EQ(writer.buffered(), 9u);
+        EXPECT_TRUE(writer.open_file(path));        // buffered records go to the new output
+
+        Document record;
+        for (int i = 1; i < 100; ++i) {
+            record["id"] = i;
+            record["name"] = "record";
+            EXPECT_TRUE(writer.write(record));
+            EXPECT_LT(writer.buffered(), 64u);
+        }
+        EXPECT_TRUE(writer.flush());
+        EXPECT_TRUE(writer.good());
+        EXPECT_EQ(writer.buffered(), 0u);
+    }
+
+    // a buffered record is accepted even when writing out fails ( no retry, no duplicate )
+    LineWriter unopened(4);
+    EXPECT_TRUE(unopened.write(Document(R"({"id":0})")));
+    EXPECT_FALSE(unopened.good());
+    EXPECT_EQ(unopened.buffered(), 9u);
+
+    LineReader reader;
+    EXPECT_TRUE(reader.open_file(path));
+    int count = 0;
+    while (reader.next()) {
+        EXPECT_TRUE(reader.valid());
+        EXPECT_EQ(reader.value()["id"].as<int>(), count++);
+    }
+    EXPECT_EQ(count, 100);
+    std::remove(path.c_str());
+}
+
+TEST(wrapidjsonTest, parallel_line_reader)
+{
+    std::string lines;
+    for (int i = 0; i < 5000; ++i) {
+        lines += (i % 1000 == 999) ? "{\"id\":}\n" : "{\"id\":" + std::to_string(i) + ",\"pad\":\"xxxxxxxxxxxxxxxx\"}\n";
+    }
+
+    // unordered
+    std::mutex mutex;
+    std::set<int> ids;
+    std::set<size_t> bad_lines;
+    ParallelLineReader reader(4, false, 1024);
+    reader.read_buffer(lines,
+        [&](size_t line, ValueRef record) {
+            std::lock_guard<std::mutex> lock(mutex);
+            EXPECT_EQ(record["id"].as<size_t>() + 1, line);
+            ids.insert(record["id"].as<int>());
+        },
+        [&](size_t line, const std::string&) {
+            std::lock_guard<std::mutex> lock(mutex);
+            bad_lines.insert(line);
+        });
+    EXPECT_EQ(ids.size(), 4995u);
+    EXPECT_EQ(bad_lines, (std::set<size_t>{1000, 2000, 3000, 4000, 5000}));
+
+    // ordered
+    std::vector<size_t> order;
+    ParallelLineReader ordered(4, true, 1024);
+    ordered.read_buffer(lines,
+        [&](size_t line, ValueRef) { order.push_back(line); },
+        [&](size_t line, const std::string& error) {
+            order.push_back(line);
+            EXPECT_EQ(error, "Error line[" + std::to_string(line) + "] offset[6]: Invalid value.");
+        });
+    EXPECT_EQ(order.size(), 5000u);
+    EXPECT_TRUE(std::is_sorted(order.begin(), order.end()));
+
+    // handler exception is thrown to the caller
+    EXPECT_THROW(ordered.read_buffer(lines, [](size_t, ValueRef) { throw std::runtime_error("stop"); }), std::runtime_error);
+}
+
+TEST(wrapidjsonTest, sax_reader)
+{
+    struct Collector : SaxHandler {
+        bool on_null() { events.push_back("null"); return true; }
+        bool on_bool(bool b) { events.push_back(b ? "true" : "false"); return true; }
+        bool on_int64(int64_t i) { events.push_back("i" + std::to_string(i)); return true; }
+        bool on_uint64(uint64_t u) { events.push_back("u" + std::to_string(u)); return true; }
+        bool on_key(string_view key) { events.push_back("k" + std::string(key)); return key != "stop"; }
+        bool on_string(string_view str) { events.push_back("s" + std::string(str)); return true; }
+        bool on_end_object(size_t count) { events.push_back("}" + std::to_string(count)); return true; }
+        std::vector<std::string> events;
+    };
+    const std::string json = R"({"a":null,"b":[true,-1,18446744073709551615],"c":"x\"y","d":1.5})";
+    const std::vector<std::string> expected = {
+        "ka", "null", "kb", "true", "i-1", "u18446744073709551615", "kc", "sx\"y", "kd", "}4"};
+
+    SaxReader reader;
+    Collector buffer;
+    EXPECT_TRUE(reader.load_from_buffer(json, buffer));
+    EXPECT_EQ(buffer.events, expected);
+
+    Collector stream;
+    std::istringstream iss(json);
+    EXPECT_TRUE(reader.load_from_stream(iss, stream));
+    EXPECT_EQ(stream.events, expected);
+
+    const std::string path = "wrapidjson_sax_test.json";
+    {
+        std::ofstream ofs(path);
+        ofs << json;
+    }
+    Collector file, mapped;
+    EXPECT_TRUE(reader.load_from_file(path, file));
+    EXPECT_EQ(file.events, expected);
+    EXPECT_TRUE(reader.load_from_mmap(path, mapped));
+    EXPECT_EQ(mapped.events, expected);
+    std::remove(path.c_str());
+
+    // handler stops the parse
+    Collector stopped;
+    EXPECT_FALSE(reader.load_from_buffer(R"({"stop":1})", stopped));
+    EXPECT_EQ(reader.get_load_error(), "Error offset[7]: Terminate parsing due to Handler error.");
+
+    // parse flags as Document
+    Collector commented;
+    BasicSaxReader<rapidjson::kParseCommentsFlag> comments;
+    EXPECT_TRUE(comments.load_from_buffer("[1 /* one */]", commented));
+    EXPECT_EQ(commented.events, std::vector<std::string>({ "i1" }));
+    EXPECT_FALSE(reader.load_from_buffer("[1 /* one */]", commented));
+
+    Collector broken;
+    EXPECT_FALSE(reader.load_from_buffer(R"([1,)", broken));
+    EXPECT_EQ(reader.get_load_error(), "Error offset[3]: Invalid value.");
+}
+
+TEST(wrapidjsonTest, load_with_projection)
+{
+    const std::string json = R"({
+        "id": 7,
+        "skip": {"deep": [1, {"x": "}]\"["}, [[]]], "s": "a\\"},
+        "user": {"name": "kim", "age": 30, "tags": ["a", "b"]},
+        "items": [{"id": 1, "v": "x"}, {"id": 2, "v": "y"}, 3],
+        "escaped": true,
+        "scalar": 5
+    })";
+
+    Document doc;
+    EXPECT_TRUE(doc.load_from_buffer(json, Projection{"/id", "/user/name", "/items/1/id", "/escaped", "/scalar/x"}));
+    std::string res;
+    doc.save_to_buffer(res);
+    EXPECT_EQ(res, R"({"id":7,"user":{"name":"kim"},"items":[null,{"id":2}],"escaped":true})");
+    EXPECT_EQ(doc["items"][1]["id"].as<int>(), 2);
+    EXPECT_EQ(doc["user"].get_object().get_value("name", std::string()), "kim");
+
+    // nested key lists and whole subtrees
+    Projection projection;
+    projection.add(std::vector<std::string>{"user"}).add(std::vector<std::string>{"user", "name"});
+    EXPECT_TRUE(doc.load_from_buffer(json, projection));
+    doc.save_to_buffer(res);
+    EXPECT_EQ(res, R"({"user":{"name":"kim","age":30,"tags":["a","b"]}})");
+
+    // selected scalars keep their index, elements past the last selected one are dropped
+    EXPECT_TRUE(doc.load_from_buffer(json, Projection{"/user/tags/1", "/items/2", "/items/0/v"}));
+    doc.save_to_buffer(res);
+    EXPECT_EQ(res, R"({"user":{"tags":[null,"b"]},"items":[{"v":"x"},null,3]})");
+
+    EXPECT_TRUE(doc.load_from_buffer(json, Projection{""}));
+    EXPECT_EQ(doc.get_object().size(), 6u);
+
+    // broken input falls back to a full parse for the error and keeps the old value
+    EXPECT_FALSE(doc.load_from_buffer(R"({"id": 1, "skip": [1, 2)", Projection{"/id"}));
+    EXPECT_EQ(doc.get_load_error(), "Error offset[23]: Missing a comma or ']' after an array element.");
+    EXPECT_EQ(doc.get_object().size(), 6u);
+
+    EXPECT_THROW(Projection{"id"}, std::runtime_error);
+}
+
+TEST(wrapidjsonTest, lazy_document)
+{
+    const std::string json = R"({"a":1,"obj":{"x":[1,2,{"y":"z"}],"s":"v"},"arr":[{"k":1},{"k":2}],"e\"k":[]})";
+
+    LazyDocument doc;
+    EXPECT_TRUE(doc.load_from_buffer(std::string(json)));
+    EXPECT_EQ(doc["a"].as<int>(), 1);
+    EXPECT_EQ(doc.find_pointer("/obj/x/2/y")->as<std::string>(), "z");
+    EXPECT_EQ(doc["obj"].get_object().get_value<std::string>("s"), std::string("v"));
+    EXPECT_TRUE(doc.find_pointer("/e\"k")->is_array());
+    EXPECT_FALSE(doc.find_pointer("/obj/x/3"));
+    EXPECT_FALSE(doc.find_pointer("/a/b"));
+    EXPECT_FALSE(doc.find_pointer("obj"));
+
+    // subtrees are parsed the first time a ValueRef reaches them, never read as strings
+    EXPECT_EQ(doc["obj"]["x"][2]["y"].as<std::string>(), "z");
+    EXPECT_TRUE(doc.find("e\"k")->is_array());
+    int sum = 0;
+    for (auto value : doc["arr"].get_array()) {
+        EXPECT_TRUE(value.is_object());
+        sum += value["k"].as<int>();
+    }
+    EXPECT_EQ(sum, 3);
+    for (auto member : doc.get_object()) {
+        EXPECT_FALSE(member.value.is_string());
+    }
+
+    std::string res;
+    doc.save_to_buffer(res);
+    EXPECT_EQ(res, json);
+
+    // untouched subtrees are written as source text, copies are parsed in full
+    LazyDocument untouched;
+    EXPECT_TRUE(untouched.load_from_buffer(string_view(json)));
+    untouched.save_to_buffer(res);
+    EXPECT_EQ(res, json);
+    EXPECT_EQ(untouched["obj"].to_string(), R"({"x":[1,2,{"y":"z"}],"s":"v"})");
+    Document copy(untouched["obj"]);
+    copy.save_to_buffer(res);
+    EXPECT_EQ(res, R"({"x":[1,2,{"y":"z"}],"s":"v"})");
+    LazyDocument expanded;
+    EXPECT_TRUE(expanded.load_from_buffer(string_view(json)));
+    EXPECT_TRUE(expanded.expand(expanded));
+    EXPECT_EQ(expanded.to_string(), json);
+    Document moved;
+    moved = std::move(untouched);
+    EXPECT_EQ(moved.to_string(), json);
+
+    // errors inside a subtree surface on access, expand and save
+    LazyDocument bad;
+    EXPECT_TRUE(bad.load_from_buffer(std::string(R"({"ok":1,"bad":{"x":}})")));
+    EXPECT_THROW(bad["bad"], std::runtime_error);
+    EXPECT_FALSE(bad.expand(bad));
+    EXPECT_FALSE(bad.find_pointer("/bad/x"));
+    EXPECT_FALSE(bad.save_to_buffer(res));
+    std::string packed;
+    EXPECT_FALSE(bad.save_to_msgpack(packed));
+
+    // top level errors keep the previous document
+    EXPECT_FALSE(bad.load_from_buffer(std::string(R"({"a":[1,2)")));
+    EXPECT_EQ(bad.get_load_error(), "Error offset[9]: Missing a comma or ']' after an array element.");
+    EXPECT_EQ(bad["ok"].as<int>(), 1);
+}
+
+TEST(wrapidjsonTest, document_flags)
+{
+    Document strict;
+    std::string res;
+
+    // NaN and Infinity
+    BasicDocument<rapidjson::kParseNanAndInfFlag, rapidjson::kWriteNanAndInfFlag> nan_inf;
+    EXPECT_TRUE(nan_inf.load_from_buffer("[NaN,Infinity,-Infinity]"));
+    EXPECT_TRUE(nan_inf.save_to_buffer(res));
+    EXPECT_EQ(res, "[NaN,Infinity,-Infinity]");
+    EXPECT_FALSE(strict.load_from_buffer("[NaN]"));
+
+    // stop when done
+    BasicDocument<rapidjson::kParseStopWhenDoneFlag> first;
+    EXPECT_TRUE(first.load_from_buffer(R"({"a":1} {"a":2})"));
+    EXPECT_EQ(first["a"].as<int>(), 1);
+    EXPECT_FALSE(strict.load_from_buffer(R"({"a":1} {"a":2})"));
+
+    // iterative parser has no recursion limit
+    BasicDocument<rapidjson::kParseIterativeFlag> iterative;
+    EXPECT_TRUE(iterative.load_from_buffer(std::string(100000, '[') + std::string(100000, ']')));
+
+    // full precision
+    BasicDocument<rapidjson::kParseFullPrecisionFlag> precise;
+    EXPECT_TRUE(precise.load_from_buffer("[0.1234567890123456789]"));
+    EXPECT_EQ(precise.get_array()[0].as<double>(), std::strtod("0.1234567890123456789", nullptr));
+
+    // encoding validation
+    BasicDocument<rapidjson::kParseValidateEncodingFlag> validating;
+    EXPECT_FALSE(validating.load_from_buffer("[\"\xff\"]"));
+    EXPECT_TRUE(strict.load_from_buffer("[\"\xff\"]"));
+}
+
+TEST(wrapidjsonTest, document_reset)
+{
+    const std::string json = R"({"a":[1,2,3],"b":"a string long enough to be allocated from the pool"})";
+
+    Document doc;
+    size_t capacity = 0;
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_TRUE(doc.load_from_buffer(json));
+        doc["c"] = std::string(1000, 'x');
+        EXPECT_EQ(doc["b"].as<std::string>(), "a string long enough to be allocated from the pool");
+        std::string res;
+        doc.save_to_buffer(res);
+        EXPECT_EQ(res.size(), json.size() + 1007);
+
+        doc.reset();
+        EXPECT_TRUE(doc.is_null());
+        if (i > 0) {
+            EXPECT_EQ(doc.get_document().GetAllocator().Capacity(), capacity);   // same block every round
+        }
+        capacity = doc.get_document().GetAllocator().Capacity();
+    }
+
+    // capped reset goes back to the default chunks
+    doc.reset(0);
+    EXPECT_TRUE(doc.load_from_buffer(json));
+    EXPECT_EQ(doc["a"].get_array().size(), 3u);
+}
+
+TEST(wrapidjsonTest, document_pool)
+{
+    DocumentPool pool(2, 4096, 1 << 16);
+    pool.prewarm(2);
+
+    const rapidjson::Document* first = nullptr;
+    {
+        auto lease = pool.acquire();
+        EXPECT_TRUE(lease->is_null());
+        EXPECT_GT(lease->get_document().GetAllocator().Capacity(), 4000u);    // pre-warmed arena
+        EXPECT_TRUE(lease->load_from_buffer(R"({"a":1})"));
+        first = &lease->get_document();
+    }
+
+    // released documents are reset and handed out again
+    auto lease = pool.acquire();
+    EXPECT_EQ(&lease->get_document(), first);
+    EXPECT_TRUE(lease->is_null());
+
+    // an arena grown by a large request is trimmed on release
+    std::string large = "[";
+    for (int i = 0; i < 20000; ++i) {
+        large += R"({"id":)" + std::to_string(i) + "},";
+    }
+    large.back() = ']';
+    EXPECT_TRUE(lease->load_from_buffer(large));
+    lease.release();
+    EXPECT_FALSE(lease);
+    lease = pool.acquire();
+    EXPECT_LE(lease->get_document().GetAllocator().Capacity(), 1u << 16);
+    lease.release();
+
+    // concurrent checkout and return
+    std::atomic<int> errors(0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&pool, &errors, t]() {
+            for (int i = 0; i < 1000; ++i) {
+                auto doc = pool.acquire();
+                if (not doc->is_null() or not doc->load_from_buffer(R"({"t":)" + std::to_string(t) + "}")
+                    or (*doc)["t"].as<int>() != t) {
+                    ++errors;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(errors.load(), 0);
+}
+
+TEST(wrapidjsonTest, document_allocator)
+{
+    const std::string json = R"({"a":[1,2,3],"b":{"c":"d"}})";
+
+    // malloc backed values
+    using CrtDocument = BasicDocument<rapidjson::kParseDefaultFlags, rapidjson::kWriteDefaultFlags, rapidjson::CrtAllocator>;
+    CrtDocument crt;
+    EXPECT_TRUE(crt.load_from_buffer(json));
+    auto a = crt["a"].get_array();
+    a.push_back(4);
+    EXPECT_EQ(a.as_vector<int>(), std::vector<int>({1,2,3,4}));
+    crt["e"] = std::string("f");
+    for (auto member : crt["b"].get_object()) {
+        EXPECT_EQ(member.name.as<std::string>(), "c");
+        EXPECT_EQ(member.value.as<std::string>(), "d");
+    }
+    EXPECT_EQ(crt["b"].get_object().get_value<std::string>("c", ""), "d");
+    CrtDocument copy(crt["b"]);
+    EXPECT_EQ(copy.to_string(), R"({"c":"d"})");
+    std::string res;
+    crt.save_to_buffer(res);
+    EXPECT_EQ(res, R"({"a":[1,2,3,4],"b":{"c":"d"},"e":"f"})");
+    crt.reset();
+    EXPECT_TRUE(crt.is_null());
+
+    // pool seeded with a user buffer
+    char buffer[4096];
+    rapidjson::MemoryPoolAllocator<> pool(buffer, sizeof(buffer));
+    size_t capacity = pool.Capacity();
+    Document doc(pool);
+    EXPECT_TRUE(doc.load_from_buffer(json));
+    EXPECT_EQ(&doc.get_document().GetAllocator(), &pool);
+    EXPECT_GT(pool.Size(), 0u);
+    EXPECT_EQ(pool.Capacity(), capacity);   // nothing allocated past the buffer
+    EXPECT_EQ(doc["a"].get_array().as_vector<int>(), std::vector<int>({1,2,3}));
+}
+
+TEST(wrapidjsonTest, small_document)
+{
+    const std::string json = R"({"a":[1,2,3],"b":{"c":"d"},"e":1.5})";
+
+    SmallDocument<> doc(json);
+    EXPECT_EQ(doc["a"].get_array().as_vector<int>(), std::vector<int>({1,2,3}));
+    EXPECT_EQ(doc["b"]["c"].as<std::string>(), "d");
+    EXPECT_EQ(doc["e"].as<double>(), 1.5);
+    size_t capacity = doc.get_document().GetAllocator().Capacity();
+    doc["f"] = std::string("g");
+    std::string res;
+    EXPECT_TRUE(doc.save_to_buffer(res));
+    EXPECT_EQ(res, R"({"a":[1,2,3],"b":{"c":"d"},"e":1.5,"f":"g"})");
+    EXPECT_EQ(doc.get_document().GetAllocator().Capacity(), capacity);    // inline pool only
+
+    Document copy(doc["b"]);
+    EXPECT_EQ(copy.to_string(), R"({"c":"d"})");
+
+    // overflow goes to the heap, reload reuses the inline pool
+    std::string large = "[";
+    for (int i = 0; i < 2000; ++i) {
+        large += R"({"id":)" + std::to_string(i) + R"(,"name":"a name longer than a slot of the stack allocator )"
+               + std::string(600, 'x') + R"("},)";
+    }
+    large.back() = ']';
+    EXPECT_TRUE(doc.load_from_buffer(large));
+    EXPECT_EQ(doc.get_array().size(), 2000u);
+    EXPECT_EQ(doc[1999]["id"].as<int>(), 1999);
+    EXPECT_TRUE(doc.save_to_buffer(res, true));
+
+    EXPECT_TRUE(doc.load_from_buffer(json));
+    EXPECT_EQ(doc.get_document().GetAllocator().Capacity(), capacity);
+    EXPECT_FALSE(doc.load_from_buffer("{\"a\":"));
+    EXPECT_EQ(doc.get_load_error(), "Error offset[5]: Invalid value.");
+    EXPECT_TRUE(doc.is_null());     // the pool was rewound for the failed load
+
+    // the stack blocks fit rapidjson's initial stacks whatever N is
+    SmallDocument<256> tiny(json);
+    EXPECT_TRUE(tiny.save_to_buffer(res));
+    EXPECT_EQ(res, json);
+}
+
+TEST(wrapidjsonTest, compressed_file)
+{
+    Document doc;
+    std::vector<int> values;
+    for (int i = 0; i < 100000; ++i) {
+        values.push_back(i);
+    }
+    doc["a"] = values;
+    doc["b"] = std::string("text");
+    std::string expected;
+    doc.save_to_buffer(expected);
+
+    std::vector<std::pair<std::string, Compression>> files = {
+        { "wrapidjson_compressed_test.json", Compression::automatic },
+        { "wrapidjson_compressed_test.json", Compression::none },
+        { "wrapidjson_compressed_test.json.gz", Compression::none },
+#ifdef WRAPIDJSON_ZLIB
+        { "wrapidjson_compressed_test.json.gz", Compression::automatic },
+        { "wrapidjson_compressed_test.gzip", Compression::gzip },
+#endif
+#ifdef WRAPIDJSON_ZSTD
+        { "wrapidjson_compressed_test.json.zst", Compression::automatic },
+        { "wrapidjson_compressed_test.zstd", Compression::zstd },
+#endif
+    };
+    for (const auto& file : files) {
+        EXPECT_TRUE(doc.save_to_file(file.first, false, file.second));
+        Document loaded;
+        EXPECT_TRUE(loaded.load_from_file(file.first, file.second));
+        std::string res;
+        loaded.save_to_buffer(res);
+        EXPECT_EQ(res, expected);
+        std::remove(file.first.c_str());
+    }
+
+    // the extension is only looked at with Compression::automatic
+    const std::string plain = "wrapidjson_compressed_test.json.zst";
+    EXPECT_TRUE(doc.save_to_file(plain));
+    Document unpacked;
+    EXPECT_TRUE(unpacked.load_from_file(plain));
+    EXPECT_EQ(unpacked.to_string(), expected);
+    std::remove(plain.c_str());
+
+    // a write error reported only when the file is closed
+    EXPECT_FALSE(doc.save_to_file("/dev/full"));
+
+#ifdef WRAPIDJSON_ZLIB
+    // truncated stream
+    const std::string path = "wrapidjson_compressed_test.json.gz";
+    EXPECT_TRUE(doc.save_to_file(path, false, Compression::automatic));
+    std::string compressed;
+    {
+        std::ifstream ifs(path, std::ios::binary);
+        compressed.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+        EXPECT_EQ(compressed.compare(0, 2, "\x1f\x8b"), 0);
+    }
+    {
+        std::ofstream ofs(path, std::ios::binary);
+        ofs << compressed.substr(0, compressed.size() / 2);
+    }
+    Document broken;
+    EXPECT_FALSE(broken.load_from_file(path, Compression::automatic));
+    std::remove(path.c_str());
+#else
+    EXPECT_FALSE(doc.save_to_file("wrapidjson_compressed_test.json.gz", false, Compression::automatic));
+#endif
+}
+
+TEST(wrapidjsonTest, msgpack_cbor)
+{
+    const std::string json = R"({"int":-5,"uint":4000000000,"int64":-9000000000,"uint64":18446744073709551615,)"
+        R"("double":1.0,"small":0.5,"str":"text","empty":"","null":null,"t":true,"f":false,)"
+        R"("array":[1,[2,3],{"a":[]}],"long":")" + std::string(300, 'x') + R"("})";
+    Document doc(json);
+
+    std::string msgpack;
+    std::string cbor;
+    EXPECT_TRUE(doc.save_to_msgpack(msgpack));
+    EXPECT_TRUE(doc.save_to_cbor(cbor));
+    EXPECT_LT(msgpack.size(), json.size());
+    EXPECT_LT(cbor.size(), json.size());
+
+    for (const std::string* binary : { &msgpack, &cbor }) {
+        Document loaded;
+        EXPECT_TRUE(binary == &msgpack ? loaded.load_from_msgpack(*binary) : loaded.load_from_cbor(*binary));
+        std::string res;
+        loaded.save_to_buffer(res);
+        EXPECT_EQ(res, json);
+        // number kinds survive the round trip
+        EXPECT_TRUE(loaded["int"].get_rvalue().IsInt());
+        EXPECT_TRUE(loaded["uint"].get_rvalue().IsUint());
+        EXPECT_FALSE(loaded["uint"].get_rvalue().IsInt());
+        EXPECT_TRUE(loaded["int64"].get_rvalue().IsInt64());
+        EXPECT_FALSE(loaded["int64"].get_rvalue().IsInt());
+        EXPECT_TRUE(loaded["uint64"].get_rvalue().IsUint64());
+        EXPECT_FALSE(loaded["uint64"].get_rvalue().IsInt64());
+        EXPECT_TRUE(loaded["double"].get_rvalue().IsDouble());
+        EXPECT_EQ(*loaded["uint64"].get<uint64_t>(), 18446744073709551615ULL);
+        EXPECT_FALSE(loaded["double"].get<int>());
+
+        for (size_t length = 0; length < binary->size(); length += 7) {
+            EXPECT_FALSE(binary == &msgpack ? loaded.load_from_msgpack(string_view(binary->data(), length))
+                                            : loaded.load_from_cbor(string_view(binary->data(), length)));
+        }
+    }
+
+    // encodings from the specifications
+    EXPECT_TRUE(doc.load_from_msgpack(string_view("\x82\xa1\x61\x01\xa1\x62\x92\xcb\x3f\xf8\x00\x00\x00\x00\x00\x00\xd0\x80", 18)));
+    EXPECT_EQ(doc.to_string(), R"({"a":1,"b":[1.5,-128]})");
+    EXPECT_TRUE(doc.load_from_cbor(string_view("\xbf\x61\x61\x01\x61\x62\x9f\x02\x03\xff\xff", 11)));    // indefinite lengths
+    EXPECT_EQ(doc.to_string(), R"({"a":1,"b":[2,3]})");
+    EXPECT_TRUE(doc.load_from_cbor(string_view("\x82\xf9\x3c\x00\x39\x03\xe7", 7)));  // half float
+    EXPECT_EQ(doc.to_string(), R"([1.0,-1000])");
+    EXPECT_FALSE(doc.load_from_cbor(string_view("\xa1\x01\x02", 3)));   // integer key
+}
+
+TEST(wrapidjsonTest, snapshot)
+{
+    const std::string json = R"({"int":-5,"uint":4000000000,"uint64":18446744073709551615,"double":1.5,)"
+        R"("str":"text","empty":"","null":null,"t":true,"f":false,)"
+        R"("rows":[{"id":1,"name":"a"},{"id":2,"name":"b"},{"id":3,"name":"c"}],"nested":[[],{}]})";
+    Document doc(json);
+    const std::string path = "wrapidjson_snapshot_test.snap";
+    EXPECT_TRUE(doc.save_snapshot(path));
+
+    SnapshotDocument snapshot;
+    EXPECT_TRUE(snapshot.is_null());
+    EXPECT_TRUE(snapshot.load_from_file(path));
+    EXPECT_TRUE(snapshot.is_object());
+    EXPECT_EQ(snapshot.to_string(), json);
+    EXPECT_EQ(snapshot.size(), 11u);
+
+    // same conversions as ValueRef
+    EXPECT_EQ(snapshot["int"].as<int>(), -5);
+    EXPECT_EQ(snapshot["uint"].as<uint32_t>(), 4000000000u);
+    EXPECT_EQ(*snapshot["uint64"].get<uint64_t>(), 18446744073709551615ULL);
+    EXPECT_FALSE(snapshot["uint64"].get<int64_t>());
+    EXPECT_EQ(snapshot["double"].as<double>(), 1.5);
+    EXPECT_FALSE(snapshot["double"].get<int>());
+    EXPECT_EQ(snapshot["str"].as<std::string>(), "text");
+    EXPECT_STREQ(snapshot["str"].as<const char*>(), "text");
+    EXPECT_TRUE(snapshot["empty"].empty());
+    EXPECT_TRUE(snapshot["null"].is_null());
+    EXPECT_TRUE(*snapshot["t"].get<bool>());
+    EXPECT_FALSE(*snapshot["f"].get<bool>());
+
+    EXPECT_TRUE(snapshot.has("rows"));
+    EXPECT_FALSE(snapshot.has("id"));       // interned, but not a member of the root
+    EXPECT_FALSE(snapshot.has("missing"));
+    EXPECT_TRUE(snapshot["missing"].is_null());
+    EXPECT_TRUE(snapshot["rows"][3].is_null());
+    EXPECT_EQ(snapshot["rows"][1]["name"].as<std::string>(), "b");
+
+    int sum = 0;
+    for (auto row : snapshot["rows"]) {
+        sum += row["id"].as<int>();
+    }
+    EXPECT_EQ(sum, 6);
+    std::vector<std::string> names;
+    for (auto member : snapshot["rows"][2].members()) {
+        names.push_back(std::string(member.name.data(), member.name.size()));
+    }
+    EXPECT_EQ(names, std::vector<std::string>({ "id", "name" }));
+    EXPECT_TRUE(snapshot["nested"][size_t(0)].empty());
+    EXPECT_TRUE(snapshot["nested"][1].is_object());
+
+    // members keep the document order whatever order their keys were interned in
+    Document reordered(R"({"x":{"b":1},"y":{"a":2,"b":3}})");
+    EXPECT_TRUE(reordered.save_snapshot(path));
+    EXPECT_TRUE(snapshot.load_from_file(path));
+    EXPECT_EQ(snapshot.to_string(), R"({"x":{"b":1},"y":{"a":2,"b":3}})");
+    EXPECT_EQ(snapshot["y"]["a"].as<int>(), 2);
+    EXPECT_EQ(snapshot["y"]["b"].as<int>(), 3);
+    EXPECT_FALSE(snapshot["x"].has("a"));
+
+    // not a snapshot
+    EXPECT_TRUE(doc.save_to_file(path));
+    EXPECT_FALSE(snapshot.load_from_file(path));
+    EXPECT_FALSE(snapshot.get_load_error().empty());
+    EXPECT_TRUE(snapshot.is_null());
+    std::remove(path.c_str());
+}
+
+TEST(wrapidjsonTest, push_parser)
+{
+    Document source;
+    std::vector<int> values;
+    for (int i = 0; i < 10000; ++i) {
+        values.push_back(i);
+    }
+    source["values"] = values;
+    source["text"] = std::string("chunked \"input\" \u00e9");
+    std::string json;
+    source.save_to_buffer(json);
+
+    for (size_t chunk_size : { size_t(1), size_t(7), size_t(4096), json.size() }) {
+        Document doc;
+        PushParser parser(doc);
+        std::string chunk;
+        for (size_t i = 0; i < json.size(); i += chunk_size) {
+            chunk = json.substr(i, chunk_size);     // reused by the caller after feed()
+            EXPECT_TRUE(parser.feed(chunk.data(), chunk.size()));
+        }
+        EXPECT_TRUE(parser.finish());
+        EXPECT_EQ(doc.to_string(), json);
+    }
+
+    // an error stops the parser early
+    Document broken;
+    PushParser parser(broken);
+    EXPECT_TRUE(parser.feed(string_view("{\"a\":[1,")));
+    bool fed = true;
+    for (int i = 0; i < 100 and fed; ++i) {
+        fed = parser.feed(string_view("x,"));
+    }
+    EXPECT_FALSE(fed);
+    EXPECT_FALSE(parser.finish());
+    EXPECT_EQ(parser.get_load_error(), "Error offset[8]: Invalid value.");     // the first x
+    EXPECT_TRUE(broken.is_null());
+
+    // truncated input, and a parser abandoned without finish()
+    Document truncated;
+    {
+        PushParser unfinished(truncated);
+        EXPECT_TRUE(unfinished.feed(string_view("[1,2")));
+        EXPECT_FALSE(unfinished.finish());
+        EXPECT_EQ(unfinished.get_load_error(), "Error offset[4]: Missing a comma or ']' after an array element.");
+        EXPECT_FALSE(unfinished.feed(string_view("]")));
+    }
+    {
+        PushParser abandoned(truncated);
+        abandoned.feed(string_view("[1,2"));
+    }
+    EXPECT_TRUE(truncated.is_null());
+
+    // a value after the root in a later chunk
+    Document single;
+    PushParser trailing(single);
+    EXPECT_TRUE(trailing.feed(string_view("[1] ")));
+    EXPECT_FALSE(trailing.feed(string_view(" x")));
+    EXPECT_FALSE(trailing.finish());
+    EXPECT_EQ(trailing.get_load_error(), "Error offset[5]: The document root must not be followed by other values.");
+    EXPECT_TRUE(single.is_null());
+
+    // with kParseStopWhenDoneFlag the document is set at the end of the root
+    using FirstDocument = BasicDocument<rapidjson::kParseStopWhenDoneFlag>;
+    FirstDocument first;
+    BasicPushParser<FirstDocument> stop(first);
+    EXPECT_TRUE(stop.feed(string_view(R"({"a":)")));
+    EXPECT_TRUE(first.is_null());
+    EXPECT_TRUE(stop.feed(string_view(R"(1} {"b")")));
+    EXPECT_EQ(first["a"].as<int>(), 1);
+    EXPECT_FALSE(stop.feed(string_view("}")));
+    EXPECT_TRUE(stop.finish());
+
+    // comments cut by the chunks
+    using CommentDocument = BasicDocument<rapidjson::kParseCommentsFlag>;
+    CommentDocument commented;
+    BasicPushParser<CommentDocument> comments(commented);
+    EXPECT_TRUE(comments.feed(string_view("[1 /* a ")));
+    EXPECT_TRUE(comments.feed(string_view("comment */, 2] // end")));
+    EXPECT_TRUE(comments.finish());
+    EXPECT_EQ(commented.to_string(), "[1,2]");
+}
+
+TEST(wrapidjsonTest, load_from_segments)
+{
+    const std::string json = R"({"name":"scattered \u00e9","values":[1,2.5,-3,true,null],"nested":{"a":[{}]}})";
+    Document expected(json);
+
+    // every split, with empty segments around the boundary
+    for (size_t split = 0; split <= json.size(); ++split) {
+        std::vector<string_view> segments = {
+            string_view(json.data(), split), string_view(), string_view(json.data() + split, json.size() - split)
+        };
+        Document doc;
+        EXPECT_TRUE(doc.load_from_segments(segments));
+        EXPECT_EQ(doc.to_string(), expected.to_string());
+    }
+
+    // one byte per iovec
+    std::vector<struct iovec> bytes(json.size());
+    for (size_t i = 0; i < json.size(); ++i) {
+        bytes[i].iov_base = const_cast<char*>(json.data() + i);
+        bytes[i].iov_len = 1;
+    }
+    Document doc;
+    EXPECT_TRUE(doc.load_from_segments(bytes.data(), bytes.size()));
+    EXPECT_EQ(doc.to_string(), expected.to_string());
+
+    // error offsets count across segments
+    const std::string broken = R"({"a":[1,2,x]})";
+    std::vector<string_view> segments = { string_view(broken.data(), 7), string_view(broken.data() + 7, broken.size() - 7) };
+    EXPECT_FALSE(doc.load_from_segments(segments));
+    EXPECT_EQ(doc.get_load_error(), "Error offset[10]: Invalid value.");
+    EXPECT_FALSE(doc.load_from_segments(segments.data(), 1));
+    EXPECT_FALSE(doc.load_from_segments(std::vector<string_view>()));
+}
+
+TEST(wrapidjsonTest, value_parse)
+{
+    Document root;
+    root["a"] = 1;
+    EXPECT_TRUE(root["e"].parse(R"({"a1":["a","b","c"],"b2":[1,2.5],"c2":{"a":"1"}})"));
+    EXPECT_EQ(root.to_string(), R"({"a":1,"e":{"a1":["a","b","c"],"b2":[1,2.5],"c2":{"a":"1"}}})");
+
+    // unchanged on error
+    EXPECT_FALSE(root["e"].parse("[1,"));
+    EXPECT_EQ(root["e"]["b2"][1].as<double>(), 2.5);
+
+    // into an array element, from streams
+    root["f"].set_array();
+    root["f"].push_back(root["a"]);
+    EXPECT_TRUE(root["f"][size_t(0)].parse("[true,null]"));
+    std::istringstream iss(R"({"s":"stream"})");
+    IStream is(iss);
+    EXPECT_TRUE(root["g"].parse_stream(is));
+    const std::string json = R"(["seg","ments"])";
+    std::vector<string_view> segments = { string_view(json.data(), 5), string_view(json.data() + 5, json.size() - 5) };
+    SegmentStream<> segment_stream(segments.data(), segments.size());
+    EXPECT_TRUE(root["h"].parse_stream(segment_stream));
+    EXPECT_EQ(root.to_string(), R"({"a":1,"e":{"a1":["a","b","c"],"b2":[1,2.5],"c2":{"a":"1"}},"f":[[true,null]],"g":{"s":"stream"},"h":["seg","ments"]})");
+
+    // values that free their memory are replaced without leaks
+    BasicDocument<rapidjson::kParseDefaultFlags, rapidjson::kWriteDefaultFlags, rapidjson::CrtAllocator> crt;
+    EXPECT_TRUE(crt["x"].parse(R"(["first",{"k":"v"}])"));
+    EXPECT_TRUE(crt["x"].parse(R"("second")"));
+    EXPECT_EQ(crt.to_string(), R"({"x":"second"})");
+}
+
+TEST(wrapidjsonTest, move_value)
+{
+    Document root(R"({"a":{"big":[1,2,3]},"b":[],"c":{}})");
+    const auto* elements = &root["a"]["big"][size_t(0)].get_rvalue();
+
+    // moves inside a document keep the same nodes
+    root["c"]["moved"] = root["a"].take();
+    EXPECT_TRUE(root["a"].is_null());
+    EXPECT_EQ(&root["c"]["moved"]["big"][size_t(0)].get_rvalue(), elements);
+
+    root["b"].get_array().push_back(root["c"]["moved"].take());
+    EXPECT_EQ(&root["b"][size_t(0)]["big"][size_t(0)].get_rvalue(), elements);
+    root["c"].get_object().insert("x", root["b"][size_t(0)]["big"].take());
+    EXPECT_EQ(&root["c"]["x"][size_t(0)].get_rvalue(), elements);
+    EXPECT_EQ(root.to_string(), R"({"a":null,"b":[{"big":null}],"c":{"moved":null,"x":[1,2,3]}})");
+
+    // across allocators the value is copied ( and the source still ends null )
+    Document other(R"([1,{"k":"v"}])");
+    root["d"] = other[1].take();
+    EXPECT_TRUE(other[1].is_null());
+    EXPECT_EQ(root["d"]["k"].as<std::string>(), "v");
+
+    // rvalue documents : stolen when they share the allocator
+    Document part(root.get_document().GetAllocator());
+    part.load_from_buffer(R"({"p":[4,5]})");
+    const auto* part_elements = &part["p"][size_t(0)].get_rvalue();
+    root["p"] = std::move(part);
+    EXPECT_TRUE(part.is_null());
+    EXPECT_EQ(&root["p"]["p"][size_t(0)].get_rvalue(), part_elements);
+    root["q"] = Document(R"([6])");
+    EXPECT_EQ(root["q"].to_string(), "[6]");
+    {
+        Document shared(root.get_document().GetAllocator());
+        shared.load_from_buffer_insitu(std::string(R"({"s":"in-situ"})"));
+        root["s"] = std::move(shared);  // copied, its buffer goes away with it
+    }
+    EXPECT_EQ(root["s"].to_string(), R"({"s":"in-situ"})");
+
+    // document to document
+    Document target;
+    target = Document(R"({"t":1})");
+    EXPECT_EQ(target.to_string(), R"({"t":1})");
+    Document insitu;
+    insitu.load_from_buffer_insitu(std::string(R"({"in":"situ"})"));
+    target = std::move(insitu);
+    EXPECT_EQ(target["in"].as<std::string>(), "situ");
+
+    // copies own their values, the source can go away
+    std::unique_ptr<Document> source(new Document());
+    source->load_from_buffer_insitu(std::string(R"({"c":["copied"]})"));
+    Document assigned(R"([0])");
+    assigned = *source;
+    EXPECT_EQ(assigned.to_string(), R"({"c":["copied"]})");
+    (*source)["c"] = 1;
+    source.reset();
+    EXPECT_EQ(assigned.to_string(), R"({"c":["copied"]})");
+
+    // a value moved out of its own parent
+    Document nested(R"({"n":{"m":[1,2]}})");
+    nested["n"] = nested["n"]["m"].take();
+    EXPECT_EQ(nested.to_string(), R"({"n":[1,2]})");
+
+    // CrtAllocator has no state, values move between documents
+    using CrtDocument = BasicDocument<rapidjson::kParseDefaultFlags, rapidjson::kWriteDefaultFlags, rapidjson::CrtAllocator>;
+    CrtDocument from(R"({"s":["long enough to be allocated on the heap"]})");
+    CrtDocument to;
+    const auto* crt_elements = &from["s"][size_t(0)].get_rvalue();
+    to["s"] = from["s"].take();
+    EXPECT_EQ(&to["s"][size_t(0)].get_rvalue(), crt_elements);
+    EXPECT_TRUE(from["s"].is_null());
+
+    // but strings of an in-situ document point into its source, they are copied out of it
+    std::unique_ptr<CrtDocument> situ(new CrtDocument());
+    situ->load_from_buffer_insitu(std::string(R"({"s":["in-situ string"],"t":["x"],"u":"y"})"));
+    to["situ"] = (*situ)["s"].take();
+    to["t"].set_array().push_back((*situ)["t"][size_t(0)].take());
+    to.get_object().insert("u", (*situ)["u"].take());
+    EXPECT_TRUE((*situ)["s"].is_null());
+    situ.reset();
+    EXPECT_EQ(to["situ"][size_t(0)].as<std::string>(), "in-situ string");
+    EXPECT_EQ(to["t"].to_string(), R"(["x"])");
+    EXPECT_EQ(to["u"].as<std::string>(), "y");
+
+    // inside one in-situ document they are still stolen
+    CrtDocument self;
+    self.load_from_buffer_insitu(std::string(R"({"a":["same source"]})"));
+    const auto* self_elements = &self["a"][size_t(0)].get_rvalue();
+    self["b"] = self["a"].take();
+    EXPECT_EQ(&self["b"][size_t(0)].get_rvalue(), self_elements);
+}
+
+TEST(wrapidjsonTest, value_serialize)
+{
+    Document doc(R"({"log":{"level":"info","tags":["a","b"],"n":1.5},"other":[1,2,3]})");
+    ValueRef log = doc["log"];
+    EXPECT_EQ(log.to_string(), R"({"level":"info","tags":["a","b"],"n":1.5})");
+
+    std::string out = "previous";
+    EXPECT_TRUE(log["tags"].to_string(out));
+    EXPECT_EQ(out, R"(["a","b"])");
+    EXPECT_TRUE(log["tags"].to_string(out, true));
+    EXPECT_EQ(out, "[\n    \"a\",\n    \"b\"\n]");
+
+    std::ostringstream oss;
+    EXPECT_TRUE(doc["other"].save_to_stream(oss));
+    EXPECT_EQ(oss.str(), "[1,2,3]");
+
+    const std::string path = "wrapidjson_value_serialize_test.json";
+    EXPECT_TRUE(log.save_to_file(path));
+    Document loaded;
+    EXPECT_TRUE(loaded.load_from_file(path));
+    EXPECT_EQ(loaded.to_string(), log.to_string());
+    std::remove(path.c_str());
+#ifdef WRAPIDJSON_ZLIB
+    EXPECT_TRUE(doc["other"].save_to_file(path, false, Compression::gzip));
+    EXPECT_TRUE(loaded.load_from_file(path, Compression::gzip));
+    EXPECT_EQ(loaded.to_string(), "[1,2,3]");
+    std::remove(path.c_str());
+#else
+    EXPECT_FALSE(doc["other"].save_to_file(path, false, Compression::gzip));
+#endif
+
+    // lazy subtrees are written as their source text
+    LazyDocument lazy;
+    EXPECT_TRUE(lazy.load_from_buffer(std::string(R"({"a":{"b":[1, 2]}})")));
+    EXPECT_EQ(lazy.to_string(), R"({"a":{"b":[1, 2]}})");
+}
@@ -0,0 +1,196 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_ARENA_H_
+#define WRAPIDJSON_ARENA_H_
+
+#include <limits>
+#include <memory>
+#include <algorithm>
+#include <type_traits>
+#include <cstdlib>
+#include <cstring>
+
+#include <rapidjson/allocators.h>
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// MemoryPoolAllocator over one owned block that grows to the peak usage
+/// ( rewind() reuses the block instead of freeing and reallocating chunks )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Arena {
+public:
+    using Allocator = rapidjson::MemoryPoolAllocator<>;
+
+    explicit Arena(size_t capacity = 0)
+        : block_(capacity > 0 ? new char[capacity] : nullptr)
+        , capacity_(capacity)
+    {
+        construct();
+    }
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena() {
+        allocator().~Allocator();
+    }
+
+    /// the address is stable across rewind()
+    Allocator& allocator() { return *reinterpret_cast<Allocator*>(&storage_); }
+    size_t capacity() const { return capacity_; }
+
+    /// drop every allocation ( values allocated from the arena must not be used afterwards ),
+    /// the block grows to fit the last round, is at least min_capacity and at most max_capacity
+    void rewind(size_t max_capacity = std::numeric_limits<size_t>::max(), size_t min_capacity = 0) {
+        size_t capacity = capacity_;
+        size_t used = allocator().Size() + CHUNK_OVERHEAD;
+        if (used > capacity) {
+            capacity = std::max(capacity * 2, used);
+        }
+        capacity = std::min(std::max(capacity, min_capacity), max_capacity);
+
+        std::unique_ptr<char[]> block;
+        if (capacity != capacity_ and capacity > 0) {
+            block.reset(new char[capacity]);
+        }
+        allocator().~Allocator();
+        if (capacity != capacity_) {
+            block_ = std::move(block);
+            capacity_ = capacity;
+        }
+        construct();
+    }
+
+private:
+    static const size_t CHUNK_OVERHEAD = 64;   // allocator headers inside the block
+
+    void construct() {
+        if (capacity_ > CHUNK_OVERHEAD) {
+            new (&storage_) Allocator(block_.get(), capacity_);
+        } else {
+            new (&storage_) Allocator();
+        }
+    }
+
+    std::unique_ptr<char[]> block_;
+    size_t                  capacity_;
+    std::aligned_storage<sizeof(Allocator), alignof(Allocator)>::type storage_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// rapidjson StackAllocator with Slots inline blocks of SlotSize bytes ( reader, document and
+/// writer stacks ), larger or extra blocks go to the heap, Free() is static so each block
+/// starts with a header naming its slot
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <size_t SlotSize, size_t Slots = 2>
+class InlineStackAllocator {
+public:
+    static const bool kNeedFree = true;
+
+    InlineStackAllocator() {
+        std::fill(used_, used_ + Slots, false);
+    }
+    InlineStackAllocator(const InlineStackAllocator&) = delete;
+    InlineStackAllocator& operator=(const InlineStackAllocator&) = delete;
+
+    void* Malloc(size_t size) {
+        if (size == 0) {
+            return nullptr;
+        }
+        if (size <= SlotSize) {
+            for (size_t i = 0; i < Slots; ++i) {
+                if (not used_[i]) {
+                    used_[i] = true;
+                    return attach(slots_ + i * SLOT, this, i);
+                }
+            }
+        }
+        void* block = std::malloc(HEADER + size);
+        return block != nullptr ? attach(block, nullptr, 0) : nullptr;
+    }
+
+    void* Realloc(void* ptr, size_t old_size, size_t new_size) {
+        if (ptr == nullptr) {
+            return Malloc(new_size);
+        }
+        if (new_size == 0) {
+            Free(ptr);
+            return nullptr;
+        }
+        Header* header = header_of(ptr);
+        if (header->owner == nullptr) {
+            void* block = std::realloc(header, HEADER + new_size);
+            return block != nullptr ? static_cast<char*>(block) + HEADER : nullptr;
+        }
+        if (new_size <= SlotSize) {
+            return ptr;
+        }
+        void* block = std::malloc(HEADER + new_size);
+        if (block == nullptr) {
+            return nullptr;
+        }
+        void* moved = attach(block, nullptr, 0);
+        memcpy(moved, ptr, std::min(old_size, new_size));
+        Free(ptr);
+        return moved;
+    }
+
+    static void Free(void* ptr) {
+        if (ptr == nullptr) {
+            return;
+        }
+        Header* header = header_of(ptr);
+        if (header->owner != nullptr) {
+            header->owner->used_[header->slot] = false;
+        } else {
+            std::free(header);
+        }
+    }
+
+private:
+    struct Header {
+        InlineStackAllocator*   owner;  // nullptr for heap blocks
+        size_t                  slot;
+    };
+    static const size_t HEADER = 16;    // keeps blocks 16 byte aligned
+    static const size_t SLOT = (HEADER + SlotSize + 15) & ~size_t(15);
+    static_assert(sizeof(Header) <= HEADER, "header does not fit");
+
+    static void* attach(void* block, InlineStackAllocator* owner, size_t slot) {
+        Header* header = static_cast<Header*>(block);
+        header->owner = owner;
+        header->slot = slot;
+        return static_cast<char*>(block) + HEADER;
+    }
+    static Header* header_of(void* ptr) {
+        return reinterpret_cast<Header*>(static_cast<char*>(ptr) - HEADER);
+    }
+
+    alignas(16) char    slots_[Slots * SLOT];
+    bool                used_[Slots];
+};
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_ARENA_H_
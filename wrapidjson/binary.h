@@ -0,0 +1,670 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_BINARY_H_
+#define WRAPIDJSON_BINARY_H_
+
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+
+#include <rapidjson/document.h>
+#include <rapidjson/memorystream.h>
+
+#include "lazy.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// big-endian output shared by the MessagePack and CBOR encoders
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Buffer>
+class BinaryOutput {
+public:
+    explicit BinaryOutput(Buffer& buffer) : buffer_(buffer) {}
+
+    void byte(uint8_t b) { buffer_.push_back(static_cast<char>(b)); }
+    void bytes(const char* data, size_t size) { buffer_.insert(buffer_.end(), data, data + size); }
+
+    /// type byte followed by value in sizeof(T) big-endian bytes
+    template <typename T>
+    void typed(uint8_t type, T value) {
+        char data[1 + sizeof(T)];
+        data[0] = static_cast<char>(type);
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            data[sizeof(T) - i] = static_cast<char>(value >> (8 * i));
+        }
+        bytes(data, sizeof(data));
+    }
+
+    void float64(uint8_t type, double d) {
+        uint64_t bits;
+        memcpy(&bits, &d, sizeof(bits));
+        typed<uint64_t>(type, bits);
+    }
+
+private:
+    Buffer& buffer_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// big-endian input shared by the MessagePack and CBOR decoders
+/////////////////////////////////////////////////////////////////////////////////////////////
+class BinaryInput {
+public:
+    static const int MAX_DEPTH = 1024;
+
+    BinaryInput(const char* begin, const char* end)
+        : p_(reinterpret_cast<const uint8_t*>(begin))
+        , end_(reinterpret_cast<const uint8_t*>(end)) {}
+
+    bool done() const { return p_ == end_; }
+    size_t remaining() const { return static_cast<size_t>(end_ - p_); }
+
+    bool byte(uint8_t& b) {
+        if (p_ == end_) {
+            return false;
+        }
+        b = *p_++;
+        return true;
+    }
+
+    bool peek(uint8_t& b) const {
+        if (p_ == end_) {
+            return false;
+        }
+        b = *p_;
+        return true;
+    }
+
+    /// T bit unsigned argument widened to n
+    template <typename T>
+    bool argument(uint64_t& n) {
+        T value;
+        if (not big_endian(value)) {
+            return false;
+        }
+        n = value;
+        return true;
+    }
+
+    template <typename T>
+    bool big_endian(T& value) {
+        if (remaining() < sizeof(T)) {
+            return false;
+        }
+        value = 0;
+        for (size_t i = 0; i < sizeof(T); ++i) {
+            value = static_cast<T>((value << 8) | *p_++);
+        }
+        return true;
+    }
+
+    bool float32(double& d) {
+        uint32_t bits;
+        float f;
+        if (not big_endian(bits)) {
+            return false;
+        }
+        memcpy(&f, &bits, sizeof(f));
+        d = f;
+        return true;
+    }
+
+    bool float64(double& d) {
+        uint64_t bits;
+        if (not big_endian(bits)) {
+            return false;
+        }
+        memcpy(&d, &bits, sizeof(d));
+        return true;
+    }
+
+    /// size bytes of the input ( a string or key )
+    bool take(size_t size, const char*& data) {
+        if (remaining() < size) {
+            return false;
+        }
+        data = reinterpret_cast<const char*>(p_);
+        p_ += size;
+        return true;
+    }
+
+    /// each element takes at least one byte, rejects counts the input cannot hold
+    bool fits(uint64_t count) const { return count <= remaining(); }
+
+private:
+    const uint8_t*  p_;
+    const uint8_t*  end_;
+};
+
+/// encode a lazy placeholder ( its source text is parsed on the fly ), false if it is invalid
+template <typename Encoder, typename Value>
+inline bool encode_lazy(Encoder& encoder, const Value& value) {
+    const LazyNode* node = lazy_node(value);
+    rapidjson::Document subtree;
+    rapidjson::MemoryStream is(node->begin, node->length);
+    subtree.ParseStream(is);
+    if (subtree.HasParseError()) {
+        return false;
+    }
+    encoder.value(subtree);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// MessagePack encoder ( integers take the smallest form, doubles are always float 64 )
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Buffer>
+class MsgpackEncoder {
+public:
+    /// lazy : strings may be LazyDocument placeholders
+    explicit MsgpackEncoder(Buffer& buffer, bool lazy = false) : out_(buffer), lazy_(lazy) {}
+
+    /// false if a lazy subtree is invalid
+    bool succeeded() const { return not failed_; }
+
+    template <typename Value>
+    void value(const Value& value) {
+        if (value.IsNull()) {
+            out_.byte(0xc0);
+        } else if (value.IsFalse()) {
+            out_.byte(0xc2);
+        } else if (value.IsTrue()) {
+            out_.byte(0xc3);
+        } else if (value.IsDouble()) {
+            out_.float64(0xcb, value.GetDouble());
+        } else if (value.IsUint64()) {
+            uint64(value.GetUint64());
+        } else if (value.IsInt64()) {
+            int64(value.GetInt64());
+        } else if (value.IsString()) {
+            if (lazy_ and lazy_node(value) != nullptr) {
+                failed_ = failed_ or not encode_lazy(*this, value);
+            } else {
+                string(value.GetString(), value.GetStringLength());
+            }
+        } else if (value.IsArray()) {
+            header(0x90, 0xdc, value.Size());
+            for (auto it = value.Begin(); it != value.End(); ++it) {
+                this->value(*it);
+            }
+        } else {
+            header(0x80, 0xde, value.MemberCount());
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                string(it->name.GetString(), it->name.GetStringLength());
+                this->value(it->value);
+            }
+        }
+    }
+
+private:
+    void uint64(uint64_t u) {
+        if (u < 0x80) {
+            out_.byte(static_cast<uint8_t>(u));
+        } else if (u <= 0xff) {
+            out_.template typed<uint8_t>(0xcc, static_cast<uint8_t>(u));
+        } else if (u <= 0xffff) {
+            out_.template typed<uint16_t>(0xcd, static_cast<uint16_t>(u));
+        } else if (u <= 0xffffffff) {
+            out_.template typed<uint32_t>(0xce, static_cast<uint32_t>(u));
+        } else {
+            out_.template typed<uint64_t>(0xcf, u);
+        }
+    }
+
+    void int64(int64_t i) {    // negative only
+        if (i >= -32) {
+            out_.byte(static_cast<uint8_t>(i));
+        } else if (i >= INT8_MIN) {
+            out_.template typed<uint8_t>(0xd0, static_cast<uint8_t>(i));
+        } else if (i >= INT16_MIN) {
+            out_.template typed<uint16_t>(0xd1, static_cast<uint16_t>(i));
+        } else if (i >= INT32_MIN) {
+            out_.template typed<uint32_t>(0xd2, static_cast<uint32_t>(i));
+        } else {
+            out_.template typed<uint64_t>(0xd3, static_cast<uint64_t>(i));
+        }
+    }
+
+    void string(const char* str, size_t length) {
+        if (length < 32) {
+            out_.byte(static_cast<uint8_t>(0xa0 | length));
+        } else if (length <= 0xff) {
+            out_.template typed<uint8_t>(0xd9, static_cast<uint8_t>(length));
+        } else if (length <= 0xffff) {
+            out_.template typed<uint16_t>(0xda, static_cast<uint16_t>(length));
+        } else {
+            out_.template typed<uint32_t>(0xdb, static_cast<uint32_t>(length));
+        }
+        out_.bytes(str, length);
+    }
+
+    /// fix ( 4 bit count ), then 16 and 32 bit forms at type16, type16 + 1
+    void header(uint8_t fix, uint8_t type16, size_t count) {
+        if (count < 16) {
+            out_.byte(static_cast<uint8_t>(fix | count));
+        } else if (count <= 0xffff) {
+            out_.template typed<uint16_t>(type16, static_cast<uint16_t>(count));
+        } else {
+            out_.template typed<uint32_t>(type16 + 1, static_cast<uint32_t>(count));
+        }
+    }
+
+    BinaryOutput<Buffer> out_;
+    bool                 lazy_;
+    bool                 failed_ = false;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Document::Populate generator for MessagePack ( bin is read as string, ext is rejected )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class MsgpackDecoder {
+public:
+    MsgpackDecoder(const char* begin, const char* end) : in_(begin, end) {}
+
+    template <typename Handler>
+    bool operator()(Handler& handler) {
+        succeeded_ = value(handler, 0) and in_.done();
+        return succeeded_;
+    }
+
+    bool succeeded() const { return succeeded_; }
+
+private:
+    template <typename Handler>
+    bool value(Handler& handler, int depth) {
+        uint8_t type;
+        if (depth > BinaryInput::MAX_DEPTH or not in_.byte(type)) {
+            return false;
+        }
+        if (type < 0x80) {
+            return handler.Uint64(type);
+        }
+        if (type >= 0xe0) {
+            return handler.Int64(static_cast<int8_t>(type));
+        }
+        if (type < 0x90) {
+            return object(handler, type & 0x0f, depth);
+        }
+        if (type < 0xa0) {
+            return array(handler, type & 0x0f, depth);
+        }
+        uint64_t length;
+        const char* str;
+        if (string_length(type, length)) {
+            return in_.take(length, str) and handler.String(str, static_cast<rapidjson::SizeType>(length), true);
+        }
+        double d;
+        switch (type) {
+        case 0xc0: return handler.Null();
+        case 0xc2: return handler.Bool(false);
+        case 0xc3: return handler.Bool(true);
+        case 0xca: return in_.float32(d) and handler.Double(d);
+        case 0xcb: return in_.float64(d) and handler.Double(d);
+        case 0xcc: return unsigned_int<uint8_t>(handler);
+        case 0xcd: return unsigned_int<uint16_t>(handler);
+        case 0xce: return unsigned_int<uint32_t>(handler);
+        case 0xcf: return unsigned_int<uint64_t>(handler);
+        case 0xd0: return signed_int<uint8_t, int8_t>(handler);
+        case 0xd1: return signed_int<uint16_t, int16_t>(handler);
+        case 0xd2: return signed_int<uint32_t, int32_t>(handler);
+        case 0xd3: return signed_int<uint64_t, int64_t>(handler);
+        case 0xdc: return in_.argument<uint16_t>(length) and array(handler, length, depth);
+        case 0xdd: return in_.argument<uint32_t>(length) and array(handler, length, depth);
+        case 0xde: return in_.argument<uint16_t>(length) and object(handler, length, depth);
+        case 0xdf: return in_.argument<uint32_t>(length) and object(handler, length, depth);
+        default: return false;  // never used, ext
+        }
+    }
+
+    /// length of str or bin ( false for other types )
+    bool string_length(uint8_t type, uint64_t& length) {
+        if (type >= 0xa0 and type < 0xc0) {
+            length = type & 0x1f;
+            return true;
+        }
+        switch (type) {
+        case 0xc4: case 0xd9: return in_.argument<uint8_t>(length);
+        case 0xc5: case 0xda: return in_.argument<uint16_t>(length);
+        case 0xc6: case 0xdb: return in_.argument<uint32_t>(length);
+        default: return false;
+        }
+    }
+
+    template <typename T, typename Handler>
+    bool unsigned_int(Handler& handler) {
+        T u;
+        return in_.big_endian(u) and handler.Uint64(u);
+    }
+
+    template <typename T, typename Signed, typename Handler>
+    bool signed_int(Handler& handler) {
+        T u;
+        return in_.big_endian(u) and handler.Int64(static_cast<Signed>(u));
+    }
+
+    template <typename Handler>
+    bool array(Handler& handler, uint64_t count, int depth) {
+        if (not in_.fits(count) or not handler.StartArray()) {
+            return false;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            if (not value(handler, depth + 1)) {
+                return false;
+            }
+        }
+        return handler.EndArray(static_cast<rapidjson::SizeType>(count));
+    }
+
+    template <typename Handler>
+    bool object(Handler& handler, uint64_t count, int depth) {
+        if (not in_.fits(count) or not handler.StartObject()) {
+            return false;
+        }
+        for (uint64_t i = 0; i < count; ++i) {
+            if (not key(handler) or not value(handler, depth + 1)) {
+                return false;
+            }
+        }
+        return handler.EndObject(static_cast<rapidjson::SizeType>(count));
+    }
+
+    template <typename Handler>
+    bool key(Handler& handler) {
+        uint8_t type;
+        uint64_t length;
+        const char* str;
+        if (not in_.byte(type) or not string_length(type, length)) {
+            return false;   // JSON keys are strings
+        }
+        return in_.take(length, str) and handler.Key(str, static_cast<rapidjson::SizeType>(length), true);
+    }
+
+    BinaryInput in_;
+    bool        succeeded_ = false;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// CBOR encoder ( definite lengths, integers take the smallest form, doubles are always float 64 )
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Buffer>
+class CborEncoder {
+public:
+    /// lazy : strings may be LazyDocument placeholders
+    explicit CborEncoder(Buffer& buffer, bool lazy = false) : out_(buffer), lazy_(lazy) {}
+
+    /// false if a lazy subtree is invalid
+    bool succeeded() const { return not failed_; }
+
+    template <typename Value>
+    void value(const Value& value) {
+        if (value.IsNull()) {
+            out_.byte(0xf6);
+        } else if (value.IsFalse()) {
+            out_.byte(0xf4);
+        } else if (value.IsTrue()) {
+            out_.byte(0xf5);
+        } else if (value.IsDouble()) {
+            out_.float64(0xfb, value.GetDouble());
+        } else if (value.IsUint64()) {
+            head(0, value.GetUint64());
+        } else if (value.IsInt64()) {
+            head(1, ~static_cast<uint64_t>(value.GetInt64()));  // -1 - n
+        } else if (value.IsString()) {
+            if (lazy_ and lazy_node(value) != nullptr) {
+                failed_ = failed_ or not encode_lazy(*this, value);
+            } else {
+                string(value.GetString(), value.GetStringLength());
+            }
+        } else if (value.IsArray()) {
+            head(4, value.Size());
+            for (auto it = value.Begin(); it != value.End(); ++it) {
+                this->value(*it);
+            }
+        } else {
+            head(5, value.MemberCount());
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+                string(it->name.GetString(), it->name.GetStringLength());
+                this->value(it->value);
+            }
+        }
+    }
+
+private:
+    void head(uint8_t major, uint64_t n) {
+        uint8_t type = static_cast<uint8_t>(major << 5);
+        if (n < 24) {
+            out_.byte(static_cast<uint8_t>(type | n));
+        } else if (n <= 0xff) {
+            out_.template typed<uint8_t>(type | 24, static_cast<uint8_t>(n));
+        } else if (n <= 0xffff) {
+            out_.template typed<uint16_t>(type | 25, static_cast<uint16_t>(n));
+        } else if (n <= 0xffffffff) {
+            out_.template typed<uint32_t>(type | 26, static_cast<uint32_t>(n));
+        } else {
+            out_.template typed<uint64_t>(type | 27, n);
+        }
+    }
+
+    void string(const char* str, size_t length) {
+        head(3, length);
+        out_.bytes(str, length);
+    }
+
+    BinaryOutput<Buffer> out_;
+    bool                 lazy_;
+    bool                 failed_ = false;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Document::Populate generator for CBOR ( byte strings are read as strings, tags are skipped,
+/// undefined is null, indefinite lengths are accepted )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class CborDecoder {
+public:
+    CborDecoder(const char* begin, const char* end) : in_(begin, end) {}
+
+    template <typename Handler>
+    bool operator()(Handler& handler) {
+        succeeded_ = value(handler, 0) and in_.done();
+        return succeeded_;
+    }
+
+    bool succeeded() const { return succeeded_; }
+
+private:
+    static const uint8_t BREAK = 0xff;
+    static const uint64_t INDEFINITE = ~uint64_t(0);
+
+    /// major type and argument of the next item ( INDEFINITE for additional info 31 )
+    bool head(uint8_t& major, uint8_t& info, uint64_t& n) {
+        uint8_t type;
+        if (not in_.byte(type)) {
+            return false;
+        }
+        major = type >> 5;
+        info = type & 0x1f;
+        if (info < 24) {
+            n = info;
+            return true;
+        }
+        switch (info) {
+        case 24: return in_.argument<uint8_t>(n);
+        case 25: return in_.argument<uint16_t>(n);
+        case 26: return in_.argument<uint32_t>(n);
+        case 27: return in_.argument<uint64_t>(n);
+        case 31: n = INDEFINITE; return major >= 2 and major <= 5;
+        default: return false;
+        }
+    }
+
+    template <typename Handler>
+    bool value(Handler& handler, int depth) {
+        uint8_t major, info;
+        uint64_t n;
+        if (depth > BinaryInput::MAX_DEPTH or not head(major, info, n)) {
+            return false;
+        }
+        switch (major) {
+        case 0:
+            return handler.Uint64(n);
+        case 1:
+            return n <= static_cast<uint64_t>(INT64_MAX) and handler.Int64(-1 - static_cast<int64_t>(n));
+        case 2:
+        case 3: {
+            std::string chunks;
+            const char* str = nullptr;
+            size_t length = 0;
+            if (not string(major, n, chunks, str, length)) {
+                return false;
+            }
+            return handler.String(str, static_cast<rapidjson::SizeType>(length), true);
+        }
+        case 4: {
+            if (n != INDEFINITE and not in_.fits(n)) {
+                return false;
+            }
+            rapidjson::SizeType count = 0;
+            if (not handler.StartArray()) {
+                return false;
+            }
+            for (; n == INDEFINITE ? not at_break() : count < n; ++count) {
+                if (not value(handler, depth + 1)) {
+                    return false;
+                }
+            }
+            return handler.EndArray(count);
+        }
+        case 5: {
+            if (n != INDEFINITE and not in_.fits(n)) {
+                return false;
+            }
+            rapidjson::SizeType count = 0;
+            if (not handler.StartObject()) {
+                return false;
+            }
+            for (; n == INDEFINITE ? not at_break() : count < n; ++count) {
+                if (not key(handler) or not value(handler, depth + 1)) {
+                    return false;
+                }
+            }
+            return handler.EndObject(count);
+        }
+        case 6:
+            return value(handler, depth + 1);  // tag of the next item
+        default:
+            return simple(handler, info, n);
+        }
+    }
+
+    template <typename Handler>
+    bool simple(Handler& handler, uint8_t info, uint64_t n) {
+        switch (info) {
+        case 20: return handler.Bool(false);
+        case 21: return handler.Bool(true);
+        case 22:
+        case 23: return handler.Null();
+        case 25: return handler.Double(half(static_cast<uint16_t>(n)));
+        case 26: {
+            uint32_t bits = static_cast<uint32_t>(n);
+            float f;
+            memcpy(&f, &bits, sizeof(f));
+            return handler.Double(f);
+        }
+        case 27: {
+            double d;
+            memcpy(&d, &n, sizeof(d));
+            return handler.Double(d);
+        }
+        default: return false;
+        }
+    }
+
+    static double half(uint16_t bits) {
+        int exponent = (bits >> 10) & 0x1f;
+        double mantissa = bits & 0x3ff;
+        double d = 0;
+        if (exponent == 0) {
+            d = std::ldexp(mantissa, -24);
+        } else if (exponent != 31) {
+            d = std::ldexp(mantissa + 1024, exponent - 25);
+        } else {
+            d = mantissa == 0 ? INFINITY : NAN;
+        }
+        return (bits & 0x8000) ? -d : d;
+    }
+
+    /// consume the break of an indefinite array or map
+    bool at_break() {
+        uint8_t type;
+        if (in_.peek(type) and type == BREAK) {
+            in_.byte(type);
+            return true;
+        }
+        return false;
+    }
+
+    /// definite strings point into the input, indefinite ones are joined into chunks
+    bool string(uint8_t major, uint64_t n, std::string& chunks, const char*& str, size_t& length) {
+        if (n != INDEFINITE) {
+            length = n;
+            return in_.take(length, str);
+        }
+        while (not at_break()) {
+            uint8_t chunk_major, info;
+            uint64_t size;
+            const char* chunk;
+            if (not head(chunk_major, info, size) or chunk_major != major or size == INDEFINITE
+                    or not in_.take(size, chunk)) {
+                return false;
+            }
+            chunks.append(chunk, size);
+        }
+        str = chunks.data();
+        length = chunks.size();
+        return true;
+    }
+
+    template <typename Handler>
+    bool key(Handler& handler) {
+        uint8_t major, info;
+        uint64_t n;
+        std::string chunks;
+        const char* str = nullptr;
+        size_t length = 0;
+        if (not head(major, info, n) or (major != 2 and major != 3) or not string(major, n, chunks, str, length)) {
+            return false;   // JSON keys are strings
+        }
+        return handler.Key(str, static_cast<rapidjson::SizeType>(length), true);
+    }
+
+    BinaryInput in_;
+    bool        succeeded_ = false;
+};
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_BINARY_H_
@@ -0,0 +1,355 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_COMPRESS_H_
+#define WRAPIDJSON_COMPRESS_H_
+
+#include <string>
+#include <memory>
+#include <cstdio>
+#include <stdexcept>
+#include <algorithm>
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// compressed files ( the build defines WRAPIDJSON_ZLIB and links zlib for gzip,
+/// WRAPIDJSON_ZSTD and libzstd for zstd, without them those files cannot be opened )
+/////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef WRAPIDJSON_ZLIB
+#include <zlib.h>
+#endif
+#ifdef WRAPIDJSON_ZSTD
+#include <zstd.h>
+#endif
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Compression of load_from_file / save_to_file
+/////////////////////////////////////////////////////////////////////////////////////////////
+enum class Compression {
+    automatic,  // by extension ( .gz : gzip, .zst : zstd, otherwise none )
+    none,
+    gzip,
+    zstd,
+};
+
+namespace detail {
+
+inline Compression compression_of(const std::string& path, Compression compression) {
+    if (compression != Compression::automatic) {
+        return compression;
+    }
+    auto ends_with = [&path](const std::string& suffix) {
+        return path.size() >= suffix.size() and path.compare(path.size() - suffix.size(), suffix.size(), suffix) == 0;
+    };
+    if (ends_with(".gz")) {
+        return Compression::gzip;
+    }
+    if (ends_with(".zst")) {
+        return Compression::zstd;
+    }
+    return Compression::none;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// rapidjson input stream over a Source ( size_t read(char*, size_t), 0 at the end )
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Source>
+class SourceReadStream {
+public:
+    using Ch = char;
+    SourceReadStream(Source& source, size_t buffer_size)
+        : source_(source)
+        , buffer_(new Ch[buffer_size])
+        , buffer_size_(buffer_size)
+        , current_(buffer_.get())
+        , last_(buffer_.get())
+        , count_(0)
+    {
+        Read();
+    }
+    SourceReadStream(const SourceReadStream&) = delete;
+    SourceReadStream& operator=(const SourceReadStream&) = delete;
+
+    Ch Peek() const { return current_ != last_ ? *current_ : '\0'; }
+    Ch Take() {
+        if (current_ == last_) {
+            return '\0';
+        }
+        Ch c = *current_++;
+        if (current_ == last_) {
+            Read();
+        }
+        return c;
+    }
+    size_t Tell() const { return count_ + static_cast<size_t>(current_ - buffer_.get()); }
+
+    Ch* PutBegin() { throw std::runtime_error("SourceReadStream::PutBegin not implement"); }
+    void Put(Ch) { throw std::runtime_error("SourceReadStream::Put not implement"); }
+    void Flush() { throw std::runtime_error("SourceReadStream::Flush not implement"); }
+    size_t PutEnd(Ch*) { throw std::runtime_error("SourceReadStream::PutEnd not implement"); }
+
+private:
+    void Read() {
+        count_ += static_cast<size_t>(last_ - buffer_.get());
+        current_ = buffer_.get();
+        last_ = buffer_.get() + source_.read(buffer_.get(), buffer_size_);
+    }
+
+    Source&                 source_;
+    std::unique_ptr<Ch[]>   buffer_;
+    size_t                  buffer_size_;
+    Ch*                     current_;
+    Ch*                     last_;
+    size_t                  count_;     // bytes before buffer_
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// rapidjson output stream over a Sink ( bool write(const char*, size_t) )
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Sink>
+class SinkWriteStream {
+public:
+    using Ch = char;
+    SinkWriteStream(Sink& sink, size_t chunk_size)
+        : sink_(sink)
+        , buffer_(new Ch[chunk_size > 0 ? chunk_size : 1])
+        , current_(buffer_.get())
+        , end_(buffer_.get() + (chunk_size > 0 ? chunk_size : 1))
+    {}
+    SinkWriteStream(const SinkWriteStream&) = delete;
+    SinkWriteStream& operator=(const SinkWriteStream&) = delete;
+
+    Ch Peek() const { throw std::runtime_error("SinkWriteStream::Peek not implement"); }
+    Ch Take() { throw std::runtime_error("SinkWriteStream::Take not implement"); }
+    size_t Tell() const { throw std::runtime_error("SinkWriteStream::Tell not implement"); }
+    Ch* PutBegin() { throw std::runtime_error("SinkWriteStream::PutBegin not implement"); }
+    void Put(Ch c) {
+        if (current_ == end_) {
+            Flush();
+        }
+        *current_++ = c;
+    }
+    void Flush() {
+        if (current_ != buffer_.get() and not sink_.write(buffer_.get(), static_cast<size_t>(current_ - buffer_.get()))) {
+            failed_ = true;
+        }
+        current_ = buffer_.get();
+    }
+    size_t PutEnd(Ch*) { throw std::runtime_error("SinkWriteStream::PutEnd not implement"); }
+
+    bool failed() const { return failed_; }
+
+private:
+    Sink&                   sink_;
+    std::unique_ptr<Ch[]>   buffer_;
+    Ch*                     current_;
+    Ch*                     end_;
+    bool                    failed_ = false;
+};
+
+#ifdef WRAPIDJSON_ZLIB
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// gzip file ( reads plain files as they are )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class GzipFile {
+public:
+    GzipFile(const std::string& path, const char* mode, unsigned buffer_size = 65536)
+        : file_(gzopen(path.c_str(), mode))
+    {
+        if (file_ != nullptr) {
+            gzbuffer(file_, buffer_size);
+        }
+    }
+    GzipFile(const GzipFile&) = delete;
+    GzipFile& operator=(const GzipFile&) = delete;
+    ~GzipFile() {
+        close();
+    }
+
+    bool is_open() const { return file_ != nullptr; }
+    bool failed() const { return failed_; }
+
+    size_t read(char* data, size_t size) {
+        int n = gzread(file_, data, static_cast<unsigned>(std::min<size_t>(size, 1u << 30)));
+        if (n < 0) {
+            failed_ = true;
+            return 0;
+        }
+        return static_cast<size_t>(n);
+    }
+
+    bool write(const char* data, size_t size) {
+        if (gzwrite(file_, data, static_cast<unsigned>(size)) != static_cast<int>(size)) {
+            failed_ = true;
+        }
+        return not failed_;
+    }
+
+    /// flush the trailer ( false if any write failed )
+    bool close() {
+        if (file_ != nullptr and gzclose(file_) != Z_OK) {
+            failed_ = true;
+        }
+        file_ = nullptr;
+        return not failed_;
+    }
+
+private:
+    gzFile  file_;
+    bool    failed_ = false;
+};
+#endif // WRAPIDJSON_ZLIB
+
+#ifdef WRAPIDJSON_ZSTD
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// zstd file reader ( frames are decompressed chunk by chunk )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ZstdFileReader {
+public:
+    explicit ZstdFileReader(const std::string& path)
+        : fp_(fopen(path.c_str(), "rb"))
+        , stream_(ZSTD_createDStream())
+        , in_size_(ZSTD_DStreamInSize())
+        , in_(new char[in_size_])
+    {
+        input_.src = in_.get();
+        input_.size = 0;
+        input_.pos = 0;
+        ZSTD_initDStream(stream_);
+    }
+    ZstdFileReader(const ZstdFileReader&) = delete;
+    ZstdFileReader& operator=(const ZstdFileReader&) = delete;
+    ~ZstdFileReader() {
+        if (fp_ != nullptr) {
+            fclose(fp_);
+        }
+        ZSTD_freeDStream(stream_);
+    }
+
+    bool is_open() const { return fp_ != nullptr and stream_ != nullptr; }
+    bool failed() const { return failed_; }
+
+    size_t read(char* data, size_t size) {
+        ZSTD_outBuffer output = { data, size, 0 };
+        while (not failed_) {
+            if (input_.pos == input_.size and not pending_) {
+                input_.size = fread(in_.get(), 1, in_size_, fp_);
+                input_.pos = 0;
+                if (input_.size == 0) {
+                    failed_ = ferror(fp_) != 0 or in_frame_;   // truncated frame
+                    break;
+                }
+            }
+            size_t ret = ZSTD_decompressStream(stream_, &output, &input_);
+            if (ZSTD_isError(ret)) {
+                failed_ = true;
+                break;
+            }
+            in_frame_ = ret != 0;
+            pending_ = output.pos == output.size;   // the decoder may hold more output
+            if (output.pos > 0) {
+                break;
+            }
+        }
+        return output.pos;
+    }
+
+private:
+    FILE*                   fp_;
+    ZSTD_DStream*           stream_;
+    size_t                  in_size_;
+    std::unique_ptr<char[]> in_;
+    ZSTD_inBuffer           input_;
+    bool                    in_frame_ = false;
+    bool                    pending_ = false;
+    bool                    failed_ = false;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// zstd file writer ( one frame )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ZstdFileWriter {
+public:
+    explicit ZstdFileWriter(const std::string& path, int level = 3)
+        : fp_(fopen(path.c_str(), "wb"))
+        , stream_(ZSTD_createCStream())
+        , out_size_(ZSTD_CStreamOutSize())
+        , out_(new char[out_size_])
+    {
+        if (stream_ != nullptr and ZSTD_isError(ZSTD_initCStream(stream_, level))) {
+            failed_ = true;
+        }
+    }
+    ZstdFileWriter(const ZstdFileWriter&) = delete;
+    ZstdFileWriter& operator=(const ZstdFileWriter&) = delete;
+    ~ZstdFileWriter() {
+        close();
+        ZSTD_freeCStream(stream_);
+    }
+
+    bool is_open() const { return fp_ != nullptr and stream_ != nullptr; }
+    bool failed() const { return failed_; }
+
+    bool write(const char* data, size_t size) {
+        ZSTD_inBuffer input = { data, size, 0 };
+        while (not failed_ and input.pos < input.size) {
+            ZSTD_outBuffer output = { out_.get(), out_size_, 0 };
+            size_t ret = ZSTD_compressStream(stream_, &output, &input);
+            failed_ = ZSTD_isError(ret) or not flush(output);
+        }
+        return not failed_;
+    }
+
+    /// end the frame ( false if any write failed )
+    bool close() {
+        if (fp_ == nullptr) {
+            return not failed_;
+        }
+        size_t remaining = 0;
+        do {
+            ZSTD_outBuffer output = { out_.get(), out_size_, 0 };
+            remaining = stream_ != nullptr ? ZSTD_endStream(stream_, &output) : 0;
+            failed_ = failed_ or ZSTD_isError(remaining) or not flush(output);
+        } while (not failed_ and remaining > 0);
+        failed_ = fclose(fp_) != 0 or failed_;
+        fp_ = nullptr;
+        return not failed_;
+    }
+
+private:
+    bool flush(const ZSTD_outBuffer& output) {
+        return fwrite(out_.get(), 1, output.pos, fp_) == output.pos;
+    }
+
+    FILE*                   fp_;
+    ZSTD_CStream*           stream_;
+    size_t                  out_size_;
+    std::unique_ptr<char[]> out_;
+    bool                    failed_ = false;
+};
+#endif // WRAPIDJSON_ZSTD
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_COMPRESS_H_
@@ -24,49 +24,238 @@
 #define WRAPIDJSON_DOCUMENT_H_
 
 #include <string>
+#include <memory>
+#include <limits>
+#include <vector>
+
+#include <sys/uio.h>
 
 #include <rapidjson/document.h>
+#include <rapidjson/writer.h>
+#include <rapidjson/prettywriter.h>
 
+#include "arena.h"
 #include "value_ref.h"
+#include "projection.h"
+#include "compress.h"
+#include "binary.h"
+#include "snapshot_format.h"
 
 namespace wrapidjson {
 
+namespace detail {
+
+/// read and write buffer of the file and stream wrappers
+static const size_t BUFFER_SIZE = 65536;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// rapidjson::GenericDocument over its own Allocator or a caller's one
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Allocator>
+struct DocumentStorage {
+    explicit DocumentStorage(Allocator* external)
+        : document(external != nullptr ? external : &allocator) {}
+
+    /// allocators without an arena keep their own memory policy
+    void rewind(size_t, size_t) {}
+
+    Allocator                                                allocator;
+    rapidjson::GenericDocument<rapidjson::UTF8<>, Allocator> document;
+};
+
+/// the default allocator is an arena that reset() can rewind
+template <>
+struct DocumentStorage<rapidjson::MemoryPoolAllocator<>> {
+    explicit DocumentStorage(rapidjson::MemoryPoolAllocator<>* external)
+        : external(external != nullptr)
+        , document(external != nullptr ? external : &arena.allocator()) {}
+
+    void rewind(size_t max_capacity, size_t min_capacity) {
+        if (not external) {
+            arena.rewind(max_capacity, min_capacity);
+        }
+    }
+
+    Arena               arena;
+    bool                external;
+    rapidjson::Document document;
+};
+
+} // namespace detail
+
+template <typename Allocator = rapidjson::MemoryPoolAllocator<>>
 class DocumentWrapper
 {
 public:
-    DocumentWrapper() : document_(std::make_shared<rapidjson::Document>()) {}
+    /// allocator ( optional ) must outlive the document, otherwise the document owns one
+    explicit DocumentWrapper(Allocator* allocator = nullptr);
     virtual ~DocumentWrapper() = default;
 protected:
-    std::shared_ptr<rapidjson::Document> document_;
+    using Storage = detail::DocumentStorage<Allocator>;
+    using GenericDocument = rapidjson::GenericDocument<rapidjson::UTF8<>, Allocator>;
+
+    std::shared_ptr<Storage>         storage_;
+    std::shared_ptr<GenericDocument> document_;  // aliases storage_
+    std::shared_ptr<void>            buffer_;    // in-situ source referenced by string values
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// Wrapper rapidjson::Document
+/// ParseFlags : rapidjson::ParseFlag ( kParseIterativeFlag, kParseFullPrecisionFlag,
+///              kParseNanAndInfFlag, kParseStopWhenDoneFlag, kParseValidateEncodingFlag ... )
+/// WriteFlags : rapidjson::WriteFlag ( kWriteNanAndInfFlag, kWriteValidateEncodingFlag ... )
+/// Allocator  : rapidjson Allocator of the values ( CrtAllocator, MemoryPoolAllocator<> ... )
 /////////////////////////////////////////////////////////////////////////////////////////////
-class Document : public DocumentWrapper, public ValueRef {
-    static const size_t BUFFER_SIZE = 65536;
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+class BasicDocument : public DocumentWrapper<Allocator>, public BasicValueRef<Allocator> {
+    template <typename> friend class BasicPushParser;
+    template <typename> friend class BasicValueRef;
+    static_assert((ParseFlags & rapidjson::kParseInsituFlag) == 0, "in-situ parsing is chosen by the loader");
+
+    static const size_t BUFFER_SIZE = detail::BUFFER_SIZE;
+    static const unsigned PARSE_FLAGS = ParseFlags;
+
+    template <typename OutputStream>
+    using Writer = rapidjson::Writer<OutputStream, rapidjson::UTF8<>, rapidjson::UTF8<>, rapidjson::CrtAllocator, WriteFlags>;
+    template <typename OutputStream>
+    using PrettyWriter = rapidjson::PrettyWriter<OutputStream, rapidjson::UTF8<>, rapidjson::UTF8<>, rapidjson::CrtAllocator, WriteFlags>;
+
 public:
-    Document();
-    explicit Document(const std::string&);
-    explicit Document(const ValueRef&);
+    using typename BasicValueRef<Allocator>::ValueRef;
+    using typename DocumentWrapper<Allocator>::GenericDocument;
 
-    ~Document() override = default;
+    BasicDocument();
+    /// values are allocated from allocator, which must outlive the document ( e.g. a
+    /// MemoryPoolAllocator seeded with a user buffer )
+    explicit BasicDocument(Allocator& allocator);
+    explicit BasicDocument(const std::string&);
+    explicit BasicDocument(const ValueRef&);
+    /// shares the value and the source of doc
+    BasicDocument(const BasicDocument& doc);
+
+    ~BasicDocument() override = default;
+
+    /// deep copy of doc's value into this document ( strings are copied, nothing is shared )
+    BasicDocument& operator=(const BasicDocument& doc);
+    /// take the value of doc ( O(1) when it shares the allocator, copied otherwise, see
+    /// ValueRef::take() ), the in-situ source its strings point into comes along
+    BasicDocument& operator=(BasicDocument&& doc);
 
     /// load JSON data
-    bool load_from_file(const std::string& path);
+    /// gzip and zstd files ( by compression, or by extension with Compression::automatic ) are
+    /// decompressed chunk by chunk into the parser
+    bool load_from_file(const std::string& path, Compression compression = Compression::none);
+    /// mmap file privately and parse in-situ ( string values point into the mapping,
+    /// the file must not be truncated while the document is alive )
+    bool load_from_mmap(const std::string& path);
     bool load_from_buffer(const std::string& buffer);
+    bool load_from_buffer(const char* buffer);
+    /// parse exactly size() bytes ( no '\0' terminator required, bytes after the view are not read )
+    bool load_from_buffer(const string_view& buffer);
+    /// build only the projected paths, other subtrees are skipped by bracket matching ( not validated )
+    bool load_from_buffer(const string_view& buffer, const Projection& projection);
+    /// in-situ parse ( string values point into the buffer ), the document takes the buffer
+    /// ( even on failure )
+    bool load_from_buffer_insitu(std::string&& buffer);
+    /// in-situ parse, the caller keeps the buffer alive as long as the document
+    bool load_from_buffer_insitu(char* buffer, size_t length);
     bool load_from_stream(std::istream& is);
+    /// parse a message scattered over segments in order ( nothing is gathered, the segments
+    /// only need to live during the call )
+    bool load_from_segments(const string_view* segments, size_t count);
+    bool load_from_segments(const std::vector<string_view>& segments);
+    bool load_from_segments(const struct iovec* segments, size_t count);
     std::string get_load_error();
 
+    /// set to null and rewind the allocator, the memory of the previous documents is kept
+    /// ( up to max_capacity ) so a reused document stops allocating once it has seen its largest input,
+    /// min_capacity bytes are made ready up front, values taken before reset() must not be used afterwards
+    /// ( only the owned default arena is rewound, other allocators just get the values released )
+    void reset(size_t max_capacity = std::numeric_limits<size_t>::max(), size_t min_capacity = 0);
+
+    /// set to null and release the in-situ source
+    ValueRef& set_null();
+
     /// save JSON data
-    bool save_to_file(const std::string& path, bool pretty = false);
+    /// gzip and zstd files ( by compression, or by extension with Compression::automatic ) are
+    /// compressed chunk by chunk from the writer
+    bool save_to_file(const std::string& path, bool pretty = false, Compression compression = Compression::none);
     bool save_to_buffer(std::string& buffer, bool pretty = false);
-    bool save_to_stream(std::ostream& os, bool pretty = false);
+    /// write straight into buffer ( cleared first, capacity reused ), empty on failure
+    template <typename Buffer>
+    bool save_to_buffer(Buffer& buffer, bool pretty = false);
+    bool save_to_stream(std::ostream& os, bool pretty = false, size_t chunk_size = BUFFER_SIZE);
+    std::string to_string() const;
+    bool to_string(std::string& out, bool pretty = false) const;
+
+    /// MessagePack and CBOR straight from / to the DOM ( numbers keep their int, uint, int64 or double
+    /// kind, map keys must be strings, binary strings are read as strings )
+    bool load_from_msgpack(const string_view& buffer);
+    bool load_from_cbor(const string_view& buffer);
+    /// buffer is cleared first ( capacity reused )
+    template <typename Buffer>
+    bool save_to_msgpack(Buffer& buffer);
+    template <typename Buffer>
+    bool save_to_cbor(Buffer& buffer);
 
-    /// get the actual rapidjson::Document by reference
-    inline rapidjson::Document& get_document() {
+    /// binary snapshot for SnapshotDocument ( opened by mmap without parsing, native byte order )
+    bool save_snapshot(const std::string& path);
+
+    /// get the actual rapidjson::GenericDocument by reference
+    inline GenericDocument& get_document() {
         return *document_;
     }
+
+protected:
+    using DocumentWrapper<Allocator>::storage_;
+    using DocumentWrapper<Allocator>::document_;
+    using DocumentWrapper<Allocator>::buffer_;
+
+    bool lazy_ = false;     // values may hold LazyDocument placeholders
+
+private:
+    /// a successful load that does not parse in-situ releases the source of the previous document
+    bool loaded(bool succeeded);
+    /// document_->Accept( handler ), placeholders are written as their source text
+    template <typename Handler>
+    bool accept(Handler& handler) const;
+    template <typename Source>
+    bool load_from_source(Source& source);
+    template <typename Sink>
+    bool save_to_sink(Sink& sink, bool pretty);
+};
+
+using Document = BasicDocument<>;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// LazyDocument ( nested objects and arrays are parsed on demand )
+/// only the top level is parsed at load, each nested object or array is kept as a placeholder
+/// over its source text ( bracket matched, not validated ) and parsed one level the first time
+/// a ValueRef reaches it ( operator[], find, iteration ), which throws std::runtime_error if the
+/// text is invalid. Reads modify the document, so they need the same locking as writes. Saving
+/// writes untouched subtrees as their source text once validated, copies into other documents
+/// parse them in full. The source must outlive the document
+/////////////////////////////////////////////////////////////////////////////////////////////
+class LazyDocument : public Document {
+public:
+    LazyDocument() = default;
+    ~LazyDocument() override = default;
+
+    bool load_from_mmap(const std::string& path);
+    /// the document takes the buffer
+    bool load_from_buffer(std::string&& buffer);
+    /// the caller keeps the buffer alive as long as the document
+    bool load_from_buffer(const string_view& buffer);
+
+    /// parse every subtree under value now ( with the allocator of value ), so later reads do not
+    /// modify the document, false if one of them is invalid
+    bool expand(const ValueRef& value);
+    /// JSON Pointer ( RFC 6901 ) lookup that expands the placeholders on the way and the
+    /// value found, nullopt if the path does not exist or crosses an invalid subtree
+    optional<ValueRef> find_pointer(const std::string& pointer);
+
+private:
+    bool load_lazy(const string_view& buffer);
 };
 
 } // namespace wrapidjson
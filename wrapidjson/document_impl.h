@@ -1,12 +1,20 @@
 #include <limits>
 #include <memory>
+#include <algorithm>
+#include <type_traits>
 #include <iostream>
 #include <fstream>
 #include <cstdio>
 
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
 #include <rapidjson/stringbuffer.h>
 #include <rapidjson/filereadstream.h>
 #include <rapidjson/filewritestream.h>
+#include <rapidjson/memorystream.h>
 #include <rapidjson/writer.h>
 #include <rapidjson/prettywriter.h>
 #include <rapidjson/error/en.h>
@@ -15,100 +23,530 @@
 namespace wrapidjson {
 
 /////////////////////////////////////////////////////////////////////////////////////////////
-/// std::istream wrapper
+/// std::istream wrapper ( reads blocks through rdbuf()->sgetn )
+/// a refill takes what the streambuf already holds ( in_avail ), or waits for one byte when it
+/// holds nothing, so a pipe or socket is not read past the bytes it has delivered. Bytes read past
+/// the document are given back to seekable streams only, on other streams they are consumed
 /////////////////////////////////////////////////////////////////////////////////////////////
 class IStream {
 public:
     using Ch = char;
-    IStream(std::istream& is) : is_(is) { }
+    IStream(std::istream& is, size_t buffer_size = detail::BUFFER_SIZE)
+        : is_(is)
+        , buffer_(new Ch[buffer_size])
+        , buffer_size_(buffer_size)
+        , current_(buffer_.get())
+        , last_(buffer_.get())
+        , count_(0)
+    {}
     IStream(const IStream&) = delete;
     IStream& operator=(const IStream&) = delete;
 
-    Ch Peek() const {
-        int c = is_.peek();
-        return c == std::char_traits<Ch>::eof() ? '\0' : static_cast<Ch>(c);
+    /// give unread bytes back to seekable streams
+    ~IStream() {
+        std::streamoff unread = last_ - current_;
+        if (unread > 0 and is_.rdbuf() != nullptr
+                and is_.rdbuf()->pubseekoff(-unread, std::ios_base::cur, std::ios_base::in) != std::streampos(-1)) {
+            is_.clear(is_.rdstate() & ~std::ios_base::eofbit);
+        }
+    }
+
+    Ch Peek() {
+        if (current_ == last_) {
+            Read();
+        }
+        return current_ != last_ ? *current_ : '\0';
     }
     Ch Take() {
-        int c = is_.get();
-        return c == std::char_traits<Ch>::eof() ? '\0' : static_cast<Ch>(c);
+        if (current_ == last_) {
+            Read();
+        }
+        return current_ != last_ ? *current_++ : '\0';
     }
-    size_t Tell() const { return static_cast<size_t>(is_.tellg()); }
+    size_t Tell() const { return count_ + static_cast<size_t>(current_ - buffer_.get()); }
 
     Ch* PutBegin() { throw std::runtime_error("IStream::PutBegin not implement"); }
     void Put(Ch) { throw std::runtime_error("IStream::Put not implement"); }
     void Flush() { throw std::runtime_error("IStream::Flush not implement"); }
     size_t PutEnd(Ch*) { throw std::runtime_error("IStream::PutEnd not implement"); }
+
 private:
-    std::istream& is_;
+    /// called once the buffer is used up ( lazily, the last byte of a document does not wait for more )
+    void Read() {
+        count_ += static_cast<size_t>(last_ - buffer_.get());
+        current_ = buffer_.get();
+        last_ = buffer_.get();
+        std::streambuf* buf = is_.rdbuf();
+        std::streamsize n = 0;
+        if (buf != nullptr) {
+            std::streamsize size = static_cast<std::streamsize>(buffer_size_);
+            std::streamsize avail = buf->in_avail();
+            if (avail == 0) {
+                n = buf->sgetn(buffer_.get(), 1);   // blocks for one byte only
+                avail = n > 0 ? buf->in_avail() : 0;
+            }
+            if (avail > 0) {
+                n += buf->sgetn(buffer_.get() + n, std::min(avail, size - n));
+            }
+        }
+        if (n <= 0) {
+            is_.setstate(std::ios_base::eofbit);
+            return;
+        }
+        last_ = buffer_.get() + n;
+    }
+
+    std::istream&           is_;
+    std::unique_ptr<Ch[]>   buffer_;
+    size_t                  buffer_size_;
+    Ch*                     current_;
+    Ch*                     last_;
+    size_t                  count_;     // bytes before buffer_
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////
-/// std::ostream wrapper
+/// std::ostream wrapper ( writes chunks through rdbuf()->sputn )
 /////////////////////////////////////////////////////////////////////////////////////////////
 class OStream {
 public:
     using Ch = char;
-    OStream(std::ostream& os) : os_(os) {}
+    OStream(std::ostream& os, size_t chunk_size = detail::BUFFER_SIZE)
+        : os_(os)
+        , buffer_(new Ch[chunk_size > 0 ? chunk_size : 1])
+        , current_(buffer_.get())
+        , end_(buffer_.get() + (chunk_size > 0 ? chunk_size : 1))
+    {}
     OStream(const OStream&) = delete;
     OStream& operator=(const OStream&) = delete;
 
+    ~OStream() {
+        try {
+            Write();
+        } catch (...) {
+        }
+    }
+
     Ch Peek() const { throw std::runtime_error("OStream::Peek not implement"); }
     Ch Take() { throw std::runtime_error("OStream::Take not implement"); }
     size_t Tell() const { throw std::runtime_error("OStream::Tell not implement"); }
     Ch* PutBegin() { throw std::runtime_error("OStream::PutBegin not implement"); }
-    void Put(Ch c) { os_.put(c); }
-    void Flush() { os_.flush(); }
+    void Put(Ch c) {
+        if (current_ == end_) {
+            Write();
+        }
+        *current_++ = c;
+    }
+    void Flush() {
+        Write();
+        os_.flush();
+    }
     size_t PutEnd(Ch*) { throw std::runtime_error("OStream::PutEnd not implement"); }
 
 private:
-    std::ostream& os_;
+    void Write() {
+        std::streamsize n = current_ - buffer_.get();
+        if (n > 0 and (os_.rdbuf() == nullptr or os_.rdbuf()->sputn(buffer_.get(), n) != n)) {
+            os_.setstate(std::ios_base::badbit);
+        }
+        current_ = buffer_.get();
+    }
+
+    std::ostream&           os_;
+    std::unique_ptr<Ch[]>   buffer_;
+    Ch*                     current_;
+    Ch*                     end_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// growable contiguous buffer wrapper ( std::string, std::vector<char> ... )
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Buffer = std::string>
+class BufferOStream {
+public:
+    using Ch = char;
+    BufferOStream(Buffer& buffer) : buffer_(buffer) {}
+    BufferOStream(const BufferOStream&) = delete;
+    BufferOStream& operator=(const BufferOStream&) = delete;
+
+    Ch Peek() const { throw std::runtime_error("BufferOStream::Peek not implement"); }
+    Ch Take() { throw std::runtime_error("BufferOStream::Take not implement"); }
+    size_t Tell() const { throw std::runtime_error("BufferOStream::Tell not implement"); }
+    Ch* PutBegin() { throw std::runtime_error("BufferOStream::PutBegin not implement"); }
+    void Put(Ch c) { buffer_.push_back(c); }
+    void Flush() {}
+    size_t PutEnd(Ch*) { throw std::runtime_error("BufferOStream::PutEnd not implement"); }
+
+private:
+    Buffer& buffer_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// length bounded in-situ stream ( '\0' terminator is not required )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class InsituStream {
+public:
+    using Ch = char;
+    InsituStream(Ch* src, size_t length)
+        : src_(src), dst_(nullptr), head_(src), end_(src + length) {}
+    InsituStream(const InsituStream&) = delete;
+    InsituStream& operator=(const InsituStream&) = delete;
+
+    Ch Peek() const { return src_ != end_ ? *src_ : '\0'; }
+    Ch Take() { return src_ != end_ ? *src_++ : '\0'; }
+    size_t Tell() const { return static_cast<size_t>(src_ - head_); }
+
+    Ch* PutBegin() { return dst_ = src_; }
+    void Put(Ch c) {
+        if (*dst_ != c) {   // don't dirty unchanged bytes ( keeps private mapped pages shared )
+            *dst_ = c;
+        }
+        ++dst_;
+    }
+    void Flush() {}
+    size_t PutEnd(Ch* begin) { return static_cast<size_t>(dst_ - begin); }
+
+private:
+    Ch* src_;
+    Ch* dst_;
+    Ch* head_;
+    Ch* end_;
+};
+
+namespace detail {
+
+inline const char* segment_data(const string_view& segment) { return segment.data(); }
+inline size_t segment_size(const string_view& segment) { return segment.size(); }
+inline const char* segment_data(const struct iovec& segment) { return static_cast<const char*>(segment.iov_base); }
+inline size_t segment_size(const struct iovec& segment) { return segment.iov_len; }
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// stream over scattered segments ( string_view, iovec ) read in order without gathering,
+/// empty segments are skipped and Tell() counts from the first segment
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Segment = string_view>
+class SegmentStream {
+public:
+    using Ch = char;
+    SegmentStream(const Segment* segments, size_t count)
+        : segment_(segments)
+        , last_(segments + count)
+        , begin_(nullptr)
+        , current_(nullptr)
+        , end_(nullptr)
+        , count_(0)
+    {
+        Next();
+    }
+    SegmentStream(const SegmentStream&) = delete;
+    SegmentStream& operator=(const SegmentStream&) = delete;
+
+    Ch Peek() const { return current_ != end_ ? *current_ : '\0'; }
+    Ch Take() {
+        if (current_ == end_) {
+            return '\0';
+        }
+        Ch c = *current_++;
+        if (current_ == end_) {
+            Next();
+        }
+        return c;
+    }
+    size_t Tell() const { return count_ + static_cast<size_t>(current_ - begin_); }
+
+    Ch* PutBegin() { throw std::runtime_error("SegmentStream::PutBegin not implement"); }
+    void Put(Ch) { throw std::runtime_error("SegmentStream::Put not implement"); }
+    void Flush() { throw std::runtime_error("SegmentStream::Flush not implement"); }
+    size_t PutEnd(Ch*) { throw std::runtime_error("SegmentStream::PutEnd not implement"); }
+
+private:
+    /// move to the next non-empty segment
+    void Next() {
+        while (current_ == end_ and segment_ != last_) {
+            count_ += static_cast<size_t>(end_ - begin_);
+            begin_ = current_ = detail::segment_data(*segment_);
+            end_ = begin_ + detail::segment_size(*segment_);
+            ++segment_;
+        }
+    }
+
+    const Segment*  segment_;   // next segment
+    const Segment*  last_;
+    const Ch*       begin_;
+    const Ch*       current_;
+    const Ch*       end_;
+    size_t          count_;     // bytes before begin_
+};
+
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// private ( copy on write ) read-write mapping of a whole file, or a shared read-only one
+/////////////////////////////////////////////////////////////////////////////////////////////
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() {
+        if (data_ != nullptr) {
+            munmap(data_, size_);
+        }
+    }
+
+    bool open(const std::string& path, bool read_only = false) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat st;
+        bool ret = (fstat(fd, &st) == 0);
+        if (ret and st.st_size > 0) {
+            void* addr = read_only
+                ? mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0)
+                : mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+            if (addr == MAP_FAILED) {
+                ret = false;
+            } else {
+                data_ = static_cast<char*>(addr);
+                size_ = static_cast<size_t>(st.st_size);
+            }
+        }
+        ::close(fd);
+        return ret;
+    }
+
+    void advise(int advice) {
+        if (data_ != nullptr) {
+            madvise(data_, size_, advice);
+        }
+    }
+
+    char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    char*   data_ = nullptr;
+    size_t  size_ = 0;
 };
 
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// DocumentWrapper
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Allocator>
+inline DocumentWrapper<Allocator>::DocumentWrapper(Allocator* allocator)
+    : storage_(std::make_shared<Storage>(allocator))
+    , document_(storage_, &storage_->document)
+{}
+
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// ValueRef::ValueRef(const Documnet&)
 /////////////////////////////////////////////////////////////////////////////////////////////
-inline ValueRef::ValueRef(const Document& doc)
-    : value_(doc.value_), alloc_(doc.alloc_)
+template <typename Allocator>
+template <unsigned ParseFlags, unsigned WriteFlags>
+inline BasicValueRef<Allocator>::BasicValueRef(const BasicDocument<ParseFlags, WriteFlags, Allocator>& doc)
+    : value_(doc.value_), alloc_(doc.alloc_), source_(doc.source_)
 {}
 
-inline ValueRef& ValueRef::operator=(const Document& doc)
+template <typename Allocator>
+template <unsigned ParseFlags, unsigned WriteFlags>
+inline BasicValueRef<Allocator>& BasicValueRef<Allocator>::operator=(const BasicDocument<ParseFlags, WriteFlags, Allocator>& doc)
 {
-    value_.CopyFrom(doc.value_, alloc_); // copy value explicitly
+    detail::assign_copy(value_, doc.value_, alloc_);    // copy value explicitly
     return *this;
 }
 
-inline std::string ValueRef::to_string()
+template <typename Allocator>
+template <unsigned ParseFlags, unsigned WriteFlags>
+inline BasicValueRef<Allocator>& BasicValueRef<Allocator>::operator=(BasicDocument<ParseFlags, WriteFlags, Allocator>&& doc)
+{
+    if (doc.lazy_ or doc.buffer_) {
+        detail::assign_copy(value_, doc.value_, alloc_);    // the source of its strings and placeholders dies with doc
+        return *this;
+    }
+    return operator=(doc.take());   // stolen from a document sharing the allocator, copied otherwise
+}
+
+template <typename Allocator>
+inline std::string BasicValueRef<Allocator>::to_string() const
 {
-    Document doc(*this);
     std::string str;
-    doc.save_to_buffer(str);
+    to_string(str);
     return str;
 }
 
+template <typename Allocator>
+inline bool BasicValueRef<Allocator>::to_string(std::string& out, bool pretty) const
+{
+    out.clear();    // keeps capacity for the next value
+    BufferOStream<std::string> os(out);
+    if (pretty) {
+        rapidjson::PrettyWriter<BufferOStream<std::string>> writer(os);
+        return detail::accept(value_, writer);
+    }
+    rapidjson::Writer<BufferOStream<std::string>> writer(os);
+    return detail::accept(value_, writer);
+}
+
+template <typename Allocator>
+inline bool BasicValueRef<Allocator>::save_to_stream(std::ostream& os, bool pretty) const
+{
+    OStream os_wrapper(os);
+    bool ret = false;
+    if (pretty) {
+        rapidjson::PrettyWriter<OStream> writer(os_wrapper);
+        ret = detail::accept(value_, writer);
+    } else {
+        rapidjson::Writer<OStream> writer(os_wrapper);
+        ret = detail::accept(value_, writer);
+    }
+    os_wrapper.Flush();
+    return ret and not os.fail();
+}
+
+template <typename Allocator>
+inline bool BasicValueRef<Allocator>::save_to_file(const std::string& path, bool pretty, Compression compression) const
+{
+    switch (detail::compression_of(path, compression)) {
+    case Compression::none:
+        break;
+#ifdef WRAPIDJSON_ZLIB
+    case Compression::gzip: {
+        detail::GzipFile file(path, "wb");
+        return file.is_open() and save_to_sink(file, pretty) and file.close();
+    }
+#endif
+#ifdef WRAPIDJSON_ZSTD
+    case Compression::zstd: {
+        detail::ZstdFileWriter file(path);
+        return file.is_open() and save_to_sink(file, pretty) and file.close();
+    }
+#endif
+    default:
+        return false;   // not built with the library
+    }
+
+    FILE* fp = fopen(path.c_str(), "w");
+    if (fp == nullptr) {
+        return false;
+    }
+
+    char writeBuffer[detail::BUFFER_SIZE];
+    rapidjson::FileWriteStream os(fp, writeBuffer, sizeof(writeBuffer));
+    bool ret = false;
+    if (pretty) {
+        rapidjson::PrettyWriter<rapidjson::FileWriteStream> writer(os);
+        ret = detail::accept(value_, writer);
+    } else {
+        rapidjson::Writer<rapidjson::FileWriteStream> writer(os);
+        ret = detail::accept(value_, writer);
+    }
+    os.Flush();
+    return fclose(fp) == 0 and ret;
+}
+
+template <typename Allocator>
+template <typename Sink>
+inline bool BasicValueRef<Allocator>::save_to_sink(Sink& sink, bool pretty) const
+{
+    detail::SinkWriteStream<Sink> os(sink, detail::BUFFER_SIZE);
+    bool ret = false;
+    if (pretty) {
+        rapidjson::PrettyWriter<detail::SinkWriteStream<Sink>> writer(os);
+        ret = detail::accept(value_, writer);
+    } else {
+        rapidjson::Writer<detail::SinkWriteStream<Sink>> writer(os);
+        ret = detail::accept(value_, writer);
+    }
+    os.Flush();
+    return ret and not os.failed();
+}
+
 
 /////////////////////////////////////////////////////////////////////////////////////////////
-/// Document::Document
+/// BasicDocument::BasicDocument
 /////////////////////////////////////////////////////////////////////////////////////////////
-inline Document::Document()
-    : DocumentWrapper()
-    , ValueRef(*document_, document_->GetAllocator())
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline BasicDocument<ParseFlags, WriteFlags, Allocator>::BasicDocument()
+    : DocumentWrapper<Allocator>()
+    , BasicValueRef<Allocator>(*document_, document_->GetAllocator(), &buffer_)
+{}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline BasicDocument<ParseFlags, WriteFlags, Allocator>::BasicDocument(Allocator& allocator)
+    : DocumentWrapper<Allocator>(&allocator)
+    , BasicValueRef<Allocator>(*document_, document_->GetAllocator(), &buffer_)
 {}
 
-inline Document::Document(const ValueRef& other)
-    : DocumentWrapper()
-    , ValueRef(*document_, document_->GetAllocator())
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline BasicDocument<ParseFlags, WriteFlags, Allocator>::BasicDocument(const ValueRef& other)
+    : DocumentWrapper<Allocator>()
+    , BasicValueRef<Allocator>(*document_, document_->GetAllocator(), &buffer_)
 {
-    value_.CopyFrom(other.get_rvalue(), alloc_); // copy value explicitly
+    detail::copy_value(this->value_, other.get_rvalue(), this->alloc_);    // copy value explicitly
 }
 
-inline Document::Document(const std::string& buffer)
-    : Document()
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline BasicDocument<ParseFlags, WriteFlags, Allocator>::BasicDocument(const std::string& buffer)
+    : BasicDocument()
 {
     load_from_buffer(buffer);
 }
 
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline BasicDocument<ParseFlags, WriteFlags, Allocator>::BasicDocument(const BasicDocument& doc)
+    : DocumentWrapper<Allocator>(doc)
+    , BasicValueRef<Allocator>(*document_, document_->GetAllocator(), &buffer_)   // not the buffer_ of doc
+    , lazy_(doc.lazy_)
+{}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline BasicDocument<ParseFlags, WriteFlags, Allocator>&
+BasicDocument<ParseFlags, WriteFlags, Allocator>::operator=(const BasicDocument& doc) {
+    if (this != &doc) {
+        ValueRef::operator=(static_cast<const ValueRef&>(doc));    // deep copy into this allocator
+        buffer_.reset();
+        lazy_ = false;
+    }
+    return *this;
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline BasicDocument<ParseFlags, WriteFlags, Allocator>&
+BasicDocument<ParseFlags, WriteFlags, Allocator>::operator=(BasicDocument&& doc) {
+    if (this != &doc) {
+        ValueRef::operator=(typename ValueRef::Taken(doc.value_, doc.alloc_, nullptr));   // its source comes along
+        buffer_ = std::move(doc.buffer_);
+        lazy_ = lazy_ or doc.lazy_;     // placeholders are stolen with the value
+    }
+    return *this;
+}
+
 /// load JSON data
-inline bool Document::load_from_file(const std::string& path) {
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_file(const std::string& path, Compression compression) {
+    switch (detail::compression_of(path, compression)) {
+    case Compression::none:
+        break;
+#ifdef WRAPIDJSON_ZLIB
+    case Compression::gzip: {
+        detail::GzipFile file(path, "rb");
+        return file.is_open() and load_from_source(file);
+    }
+#endif
+#ifdef WRAPIDJSON_ZSTD
+    case Compression::zstd: {
+        detail::ZstdFileReader file(path);
+        return file.is_open() and load_from_source(file);
+    }
+#endif
+    default:
+        return false;   // not built with the library
+    }
+
     FILE* fp = fopen(path.c_str(), "r");
     if (fp == nullptr) {
         return false;
@@ -116,29 +554,169 @@ inline bool Document::load_from_file(const std::string& path) {
 
     char    readBuffer[BUFFER_SIZE];
     rapidjson::FileReadStream is(fp, readBuffer, BUFFER_SIZE);
-    document_->ParseStream(is);
+    document_->template ParseStream<ParseFlags>(is);
     fclose(fp);
-    return not document_->HasParseError();
+    return loaded(not document_->HasParseError());
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+template <typename Source>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_source(Source& source) {
+    detail::SourceReadStream<Source> is(source, BUFFER_SIZE);
+    document_->template ParseStream<ParseFlags>(is);
+    return loaded(not document_->HasParseError() and not source.failed());
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_mmap(const std::string& path) {
+    auto mapped = std::make_shared<detail::MappedFile>();
+    if (not mapped->open(path)) {
+        return false;
+    }
+
+    mapped->advise(MADV_SEQUENTIAL);
+    InsituStream is(mapped->data(), mapped->size());
+    document_->template ParseStream<ParseFlags | rapidjson::kParseInsituFlag>(is);
+    mapped->advise(MADV_NORMAL);
+    if (document_->HasParseError()) {
+        return false;
+    }
+    buffer_ = mapped;   // string values point into the mapping, keep it with the document
+    lazy_ = false;
+    return true;
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_buffer(const std::string& buffer) {
+    document_->template Parse<ParseFlags>(buffer.c_str());
+    return loaded(not document_->HasParseError());
 }
 
-inline bool Document::load_from_buffer(const std::string& buffer) {
-    document_->Parse<0>(buffer.c_str());
-    return not document_->HasParseError();
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_buffer(const char* buffer) {
+    document_->template Parse<ParseFlags>(buffer);
+    return loaded(not document_->HasParseError());
 }
-inline bool Document::load_from_stream(std::istream& is) {
-    IStream is_wrapper(is);
-    document_->ParseStream(is_wrapper);
-    return not document_->HasParseError();
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_buffer(const string_view& buffer) {
+    rapidjson::MemoryStream is(buffer.data(), buffer.size());
+    document_->template ParseStream<ParseFlags>(is);
+    return loaded(not document_->HasParseError());
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_buffer(const string_view& buffer, const Projection& projection) {
+    detail::ProjectionParser<ParseFlags> parser(buffer, projection);
+    document_->Populate(parser);
+    if (not parser.succeeded()) {
+        return load_from_buffer(buffer);    // full parse reports the error offset
+    }
+    return loaded(true);
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_buffer_insitu(std::string&& buffer) {
+    auto owned = std::make_shared<std::string>(std::move(buffer));
+    if (not load_from_buffer_insitu(&(*owned)[0], owned->size())) {
+        return false;
+    }
+    buffer_ = owned;    // string values point into the buffer, keep it with the document
+    return true;
 }
 
-inline std::string Document::get_load_error() {
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_buffer_insitu(char* buffer, size_t length) {
+    InsituStream is(buffer, length);
+    document_->template ParseStream<ParseFlags | rapidjson::kParseInsituFlag>(is);
+    return loaded(not document_->HasParseError());  // the caller owns this buffer
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_stream(std::istream& is) {
+    IStream is_wrapper(is, BUFFER_SIZE);
+    document_->template ParseStream<ParseFlags>(is_wrapper);
+    return loaded(not document_->HasParseError());
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_segments(const string_view* segments, size_t count) {
+    SegmentStream<string_view> is(segments, count);
+    document_->template ParseStream<ParseFlags>(is);
+    return loaded(not document_->HasParseError());
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_segments(const std::vector<string_view>& segments) {
+    return load_from_segments(segments.data(), segments.size());
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_segments(const struct iovec* segments, size_t count) {
+    SegmentStream<struct iovec> is(segments, count);
+    document_->template ParseStream<ParseFlags>(is);
+    return loaded(not document_->HasParseError());
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline std::string BasicDocument<ParseFlags, WriteFlags, Allocator>::get_load_error() {
     return detail::format("Error offset[%u]: %s",
             (unsigned)document_->GetErrorOffset(),
             rapidjson::GetParseError_En(document_->GetParseError()));
 }
 
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline void BasicDocument<ParseFlags, WriteFlags, Allocator>::reset(size_t max_capacity, size_t min_capacity) {
+    document_->SetNull();
+    storage_->rewind(max_capacity, min_capacity);
+    buffer_.reset();
+    lazy_ = false;
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline typename BasicDocument<ParseFlags, WriteFlags, Allocator>::ValueRef& BasicDocument<ParseFlags, WriteFlags, Allocator>::set_null() {
+    buffer_.reset();
+    lazy_ = false;
+    return ValueRef::set_null();
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::loaded(bool succeeded) {
+    if (succeeded) {
+        buffer_.reset();
+        lazy_ = false;
+    }
+    return succeeded;
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+template <typename Handler>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::accept(Handler& handler) const {
+    return lazy_ ? detail::accept(*document_, handler) : document_->Accept(handler);
+}
+
 /// save JSON data
-inline bool Document::save_to_file(const std::string& path, bool pretty) {
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::save_to_file(const std::string& path, bool pretty, Compression compression) {
+    switch (detail::compression_of(path, compression)) {
+    case Compression::none:
+        break;
+#ifdef WRAPIDJSON_ZLIB
+    case Compression::gzip: {
+        detail::GzipFile file(path, "wb");
+        return file.is_open() and save_to_sink(file, pretty) and file.close();
+    }
+#endif
+#ifdef WRAPIDJSON_ZSTD
+    case Compression::zstd: {
+        detail::ZstdFileWriter file(path);
+        return file.is_open() and save_to_sink(file, pretty) and file.close();
+    }
+#endif
+    default:
+        return false;   // not built with the library
+    }
+
     FILE* fp = fopen(path.c_str(), "w");
     if (fp == nullptr) {
         return false;
@@ -149,41 +727,214 @@ inline bool Document::save_to_file(const std::string& path, bool pretty) {
 
     bool ret = false;
     if (pretty) {
-        rapidjson::PrettyWriter<rapidjson::FileWriteStream> writer(os);
-        ret = document_->Accept(writer);
+        PrettyWriter<rapidjson::FileWriteStream> writer(os);
+        ret = accept(writer);
     } else{
-        rapidjson::Writer<rapidjson::FileWriteStream> writer(os);
-        ret = document_->Accept(writer);
+        Writer<rapidjson::FileWriteStream> writer(os);
+        ret = accept(writer);
     }
-    fclose(fp);
-    return ret;
+    os.Flush();
+    return fclose(fp) == 0 and ret;     // a full disk shows up when the last block is written
 }
 
-inline bool Document::save_to_buffer(std::string& buffer, bool pretty) {
-    rapidjson::StringBuffer stringBuf;
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+template <typename Sink>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::save_to_sink(Sink& sink, bool pretty) {
+    detail::SinkWriteStream<Sink> os(sink, BUFFER_SIZE);
+    bool ret = false;
+    if (pretty) {
+        PrettyWriter<detail::SinkWriteStream<Sink>> writer(os);
+        ret = accept(writer);
+    } else {
+        Writer<detail::SinkWriteStream<Sink>> writer(os);
+        ret = accept(writer);
+    }
+    os.Flush();
+    return ret and not os.failed();
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::save_to_buffer(std::string& buffer, bool pretty) {
+    return this->template save_to_buffer<std::string>(buffer, pretty);
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+template <typename Buffer>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::save_to_buffer(Buffer& buffer, bool pretty) {
+    buffer.clear();     // keeps capacity for the next document
+    BufferOStream<Buffer> os(buffer);
     bool ret = false;
     if (pretty){
-        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(stringBuf);
-        ret = document_->Accept(writer);
+        PrettyWriter<BufferOStream<Buffer>> writer(os);
+        ret = accept(writer);
     } else {
-        rapidjson::Writer<rapidjson::StringBuffer> writer(stringBuf);
-        ret = document_->Accept(writer);
+        Writer<BufferOStream<Buffer>> writer(os);
+        ret = accept(writer);
     }
-    if ( ret ) {
-        buffer.assign(stringBuf.GetString(), stringBuf.GetSize());
+    if (not ret) {
+        buffer.clear();     // no partial document
     }
     return ret;
 }
 
-inline bool Document::save_to_stream(std::ostream& os, bool pretty) {
-    OStream os_wrapper(os);
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::save_to_stream(std::ostream& os, bool pretty, size_t chunk_size) {
+    OStream os_wrapper(os, chunk_size);
+    bool ret = false;
     if (pretty) {
-        rapidjson::PrettyWriter<OStream> writer(os_wrapper);
-        return document_->Accept(writer);
+        PrettyWriter<OStream> writer(os_wrapper);
+        ret = accept(writer);
     } else {
-        rapidjson::Writer<OStream> writer(os_wrapper);
-        return document_->Accept(writer);
+        Writer<OStream> writer(os_wrapper);
+        ret = accept(writer);
+    }
+    os_wrapper.Flush();
+    return ret and not os.fail();
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline std::string BasicDocument<ParseFlags, WriteFlags, Allocator>::to_string() const {
+    std::string str;
+    to_string(str);
+    return str;
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::to_string(std::string& out, bool pretty) const {
+    out.clear();    // keeps capacity for the next document
+    BufferOStream<std::string> os(out);
+    if (pretty) {
+        PrettyWriter<BufferOStream<std::string>> writer(os);
+        return accept(writer);
+    }
+    Writer<BufferOStream<std::string>> writer(os);
+    return accept(writer);
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_msgpack(const string_view& buffer) {
+    detail::MsgpackDecoder decoder(buffer.data(), buffer.data() + buffer.size());
+    document_->Populate(decoder);
+    return loaded(decoder.succeeded());
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::load_from_cbor(const string_view& buffer) {
+    detail::CborDecoder decoder(buffer.data(), buffer.data() + buffer.size());
+    document_->Populate(decoder);
+    return loaded(decoder.succeeded());
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+template <typename Buffer>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::save_to_msgpack(Buffer& buffer) {
+    buffer.clear();     // keeps capacity for the next document
+    detail::MsgpackEncoder<Buffer> encoder(buffer, lazy_);
+    encoder.value(*document_);
+    return encoder.succeeded();
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+template <typename Buffer>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::save_to_cbor(Buffer& buffer) {
+    buffer.clear();     // keeps capacity for the next document
+    detail::CborEncoder<Buffer> encoder(buffer, lazy_);
+    encoder.value(*document_);
+    return encoder.succeeded();
+}
+
+template <unsigned ParseFlags, unsigned WriteFlags, typename Allocator>
+inline bool BasicDocument<ParseFlags, WriteFlags, Allocator>::save_snapshot(const std::string& path) {
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        return false;
+    }
+    detail::SnapshotWriter writer(fp, lazy_);
+    bool ret = writer.write(*document_);
+    return fclose(fp) == 0 and ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// LazyDocument
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline bool LazyDocument::load_from_mmap(const std::string& path) {
+    auto mapped = std::make_shared<detail::MappedFile>();
+    if (not mapped->open(path)) {
+        return false;
+    }
+    if (not load_lazy(string_view(mapped->data(), mapped->size()))) {
+        return false;
+    }
+    buffer_ = mapped;   // placeholders point into the mapping
+    return true;
+}
+
+inline bool LazyDocument::load_from_buffer(std::string&& buffer) {
+    auto owned = std::make_shared<std::string>(std::move(buffer));
+    if (not load_lazy(*owned)) {
+        return false;
+    }
+    buffer_ = owned;    // placeholders point into the buffer
+    return true;
+}
+
+inline bool LazyDocument::load_from_buffer(const string_view& buffer) {
+    if (not load_lazy(buffer)) {
+        return false;
+    }
+    buffer_.reset();
+    return true;
+}
+
+inline bool LazyDocument::expand(const ValueRef& value) {
+    return detail::parse_all(value.value_, value.alloc_);
+}
+
+inline optional<LazyDocument::ValueRef> LazyDocument::find_pointer(const std::string& pointer) {
+    optional<ValueRef> ret;
+    std::vector<std::string> keys;
+    if (not detail::split_pointer(pointer, keys)) {
+        return ret;
+    }
+    rapidjson::MemoryPoolAllocator<>& alloc = document_->GetAllocator();
+    Value* value = document_.get();
+    for (auto& key : keys) {
+        if (not detail::materialize(*value, alloc)) {
+            return ret;
+        }
+        if (value->IsObject()) {
+            auto it = value->FindMember(Value(rapidjson::StringRef(key.data(), key.size())));
+            if (it == value->MemberEnd()) {
+                return ret;
+            }
+            value = &it->value;
+        } else if (value->IsArray()) {
+            if (key.empty() or key.size() > 9 or key.find_first_not_of("0123456789") != std::string::npos) {
+                return ret;
+            }
+            rapidjson::SizeType idx = static_cast<rapidjson::SizeType>(std::stoul(key));
+            if (idx >= value->Size()) {
+                return ret;
+            }
+            value = &(*value)[idx];
+        } else {
+            return ret;
+        }
+    }
+    if (detail::materialize(*value, alloc)) {
+        ret = ValueRef(*value, alloc, &buffer_);
+    }
+    return ret;
+}
+
+inline bool LazyDocument::load_lazy(const string_view& buffer) {
+    detail::LazyParser<> parser(buffer.data(), buffer.data() + buffer.size(), document_->GetAllocator());
+    document_->Populate(parser);
+    if (not parser.succeeded()) {
+        return Document::load_from_buffer(buffer);  // full parse reports the error offset
     }
+    lazy_ = true;
+    return true;
 }
 
 } // namespace wrapidjson
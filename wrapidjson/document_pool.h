@@ -0,0 +1,127 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_DOCUMENT_POOL_H_
+#define WRAPIDJSON_DOCUMENT_POOL_H_
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+
+#include "document.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// lock-free stack of slot indices ( Treiber stack, a tag in the upper half of head prevents ABA )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class IndexStack {
+public:
+    static const uint32_t EMPTY = 0xffffffff;
+
+    explicit IndexStack(size_t size);
+    IndexStack(const IndexStack&) = delete;
+    IndexStack& operator=(const IndexStack&) = delete;
+
+    void push(uint32_t index);
+    /// EMPTY if there is no index
+    uint32_t pop();
+
+private:
+    std::unique_ptr<std::atomic<uint32_t>[]>    next_;
+    std::atomic<uint64_t>                       head_;
+};
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// pool of reusable documents for request handlers
+/// acquire() hands out a Lease ( RAII ), releasing it resets the document and keeps its arena
+/// for the next lease, arenas over max_arena_size are trimmed on release, checkout and return
+/// are lock-free, the pool must outlive its leases
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename DocumentType = Document>
+class BasicDocumentPool {
+    static const size_t ARENA_SIZE = 65536;
+    static const size_t MAX_ARENA_SIZE = 4 << 20;
+public:
+    class Lease {
+    public:
+        Lease() = default;
+        Lease(Lease&& other) noexcept;
+        Lease& operator=(Lease&& other) noexcept;
+        ~Lease() { release(); }
+
+        DocumentType& operator*() const { return *document_; }
+        DocumentType* operator->() const { return document_.get(); }
+        DocumentType* get() const { return document_.get(); }
+        explicit operator bool() const { return document_ != nullptr; }
+
+        /// give the document back before the lease goes out of scope
+        void release();
+
+    private:
+        friend class BasicDocumentPool;
+        Lease(BasicDocumentPool* pool, std::unique_ptr<DocumentType> document)
+            : pool_(pool), document_(std::move(document)) {}
+
+        BasicDocumentPool*              pool_ = nullptr;
+        std::unique_ptr<DocumentType>   document_;
+    };
+
+    /// keeps at most max_idle documents, each with arena_size to max_arena_size bytes of arena
+    explicit BasicDocumentPool(size_t max_idle = 64,
+                               size_t arena_size = ARENA_SIZE,
+                               size_t max_arena_size = MAX_ARENA_SIZE);
+    BasicDocumentPool(const BasicDocumentPool&) = delete;
+    BasicDocumentPool& operator=(const BasicDocumentPool&) = delete;
+    ~BasicDocumentPool();
+
+    /// create idle documents up front
+    void prewarm(size_t count);
+    /// an idle document or a new one when the pool is empty
+    Lease acquire();
+
+    size_t max_idle() const { return max_idle_; }
+    size_t arena_size() const { return arena_size_; }
+    size_t max_arena_size() const { return max_arena_size_; }
+
+private:
+    std::unique_ptr<DocumentType> create() const;
+    void release(std::unique_ptr<DocumentType> document);
+
+    size_t                              max_idle_;
+    size_t                              arena_size_;
+    size_t                              max_arena_size_;
+    std::unique_ptr<DocumentType*[]>    slots_;
+    detail::IndexStack                  idle_;      // slots holding a document
+    detail::IndexStack                  free_;      // empty slots
+};
+
+using DocumentPool = BasicDocumentPool<>;
+
+} // namespace wrapidjson
+
+#include "document_pool_impl.h"
+
+#endif // WRAPIDJSON_DOCUMENT_POOL_H_
@@ -0,0 +1,126 @@
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// IndexStack
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline IndexStack::IndexStack(size_t size)
+    : next_(new std::atomic<uint32_t>[size])
+    , head_(EMPTY)
+{}
+
+inline void IndexStack::push(uint32_t index) {
+    uint64_t head = head_.load(std::memory_order_relaxed);
+    uint64_t tagged;
+    do {
+        next_[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+        tagged = (((head >> 32) + 1) << 32) | index;
+    } while (not head_.compare_exchange_weak(head, tagged, std::memory_order_release, std::memory_order_relaxed));
+}
+
+inline uint32_t IndexStack::pop() {
+    uint64_t head = head_.load(std::memory_order_acquire);
+    for (;;) {
+        uint32_t index = static_cast<uint32_t>(head);
+        if (index == EMPTY) {
+            return EMPTY;
+        }
+        // next_ may be stale if another thread popped index meanwhile, the tag makes the CAS fail then
+        uint32_t next = next_[index].load(std::memory_order_relaxed);
+        uint64_t tagged = (((head >> 32) + 1) << 32) | next;
+        if (head_.compare_exchange_weak(head, tagged, std::memory_order_acquire, std::memory_order_acquire)) {
+            return index;
+        }
+    }
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// BasicDocumentPool::Lease
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename DocumentType>
+inline BasicDocumentPool<DocumentType>::Lease::Lease(Lease&& other) noexcept
+    : pool_(other.pool_), document_(std::move(other.document_))
+{}
+
+template <typename DocumentType>
+inline typename BasicDocumentPool<DocumentType>::Lease&
+BasicDocumentPool<DocumentType>::Lease::operator=(Lease&& other) noexcept {
+    if (this != &other) {
+        release();
+        pool_ = other.pool_;
+        document_ = std::move(other.document_);
+    }
+    return *this;
+}
+
+template <typename DocumentType>
+inline void BasicDocumentPool<DocumentType>::Lease::release() {
+    if (document_) {
+        pool_->release(std::move(document_));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// BasicDocumentPool
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename DocumentType>
+inline BasicDocumentPool<DocumentType>::BasicDocumentPool(size_t max_idle, size_t arena_size, size_t max_arena_size)
+    : max_idle_(max_idle)
+    , arena_size_(std::min(arena_size, max_arena_size))
+    , max_arena_size_(max_arena_size)
+    , slots_(new DocumentType*[max_idle]())
+    , idle_(max_idle)
+    , free_(max_idle)
+{
+    for (size_t i = max_idle; i > 0; --i) {
+        free_.push(static_cast<uint32_t>(i - 1));
+    }
+}
+
+template <typename DocumentType>
+inline BasicDocumentPool<DocumentType>::~BasicDocumentPool() {
+    for (uint32_t index = idle_.pop(); index != detail::IndexStack::EMPTY; index = idle_.pop()) {
+        delete slots_[index];
+    }
+}
+
+template <typename DocumentType>
+inline void BasicDocumentPool<DocumentType>::prewarm(size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        release(create());
+    }
+}
+
+template <typename DocumentType>
+inline typename BasicDocumentPool<DocumentType>::Lease BasicDocumentPool<DocumentType>::acquire() {
+    uint32_t index = idle_.pop();
+    if (index == detail::IndexStack::EMPTY) {
+        return Lease(this, create());
+    }
+    std::unique_ptr<DocumentType> document(slots_[index]);
+    slots_[index] = nullptr;
+    free_.push(index);
+    return Lease(this, std::move(document));
+}
+
+template <typename DocumentType>
+inline std::unique_ptr<DocumentType> BasicDocumentPool<DocumentType>::create() const {
+    std::unique_ptr<DocumentType> document(new DocumentType());
+    document->reset(max_arena_size_, arena_size_);
+    return document;
+}
+
+template <typename DocumentType>
+inline void BasicDocumentPool<DocumentType>::release(std::unique_ptr<DocumentType> document) {
+    document->reset(max_arena_size_, arena_size_);  // trims an arena grown over max_arena_size
+    uint32_t index = free_.pop();
+    if (index == detail::IndexStack::EMPTY) {
+        return;     // pool is full, the document is freed
+    }
+    slots_[index] = document.release();
+    idle_.push(index);
+}
+
+} // namespace wrapidjson
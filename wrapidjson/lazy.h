@@ -0,0 +1,327 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_LAZY_H_
+#define WRAPIDJSON_LAZY_H_
+
+#include <cstdint>
+#include <cstring>
+
+#include <rapidjson/document.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+
+#include "scan.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// LazyNode : byte range of an object or array that is not parsed yet
+/// kept in the document pool, the value holding it is a const string of the node ( placeholder )
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct LazyNode {
+    static const uint64_t MAGIC = 0x4e4f534a595a414cULL;
+
+    uint64_t        magic;
+    const LazyNode* self;       // an ordinary string never holds its own address
+    const char*     begin;
+    size_t          length;
+};
+
+inline const LazyNode* lazy_node(const char* str, size_t length) {
+    if (length != sizeof(LazyNode)) {
+        return nullptr;
+    }
+    LazyNode node;
+    memcpy(&node, str, sizeof(node));   // ordinary strings may be unaligned
+    if (node.magic != LazyNode::MAGIC or node.self != reinterpret_cast<const LazyNode*>(str)) {
+        return nullptr;
+    }
+    return node.self;
+}
+
+template <typename Value>
+inline const LazyNode* lazy_node(const Value& value) {
+    return value.IsString() ? lazy_node(value.GetString(), value.GetStringLength()) : nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Document::Populate generator: parses one level, nested objects and arrays become placeholders
+/// ( placeholders are allocated from alloc )
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Allocator = rapidjson::MemoryPoolAllocator<>>
+class LazyParser {
+public:
+    LazyParser(const char* begin, const char* end, Allocator& alloc)
+        : begin_(begin), end_(end), alloc_(alloc) {}
+
+    template <typename Handler>
+    bool operator()(Handler& handler) {
+        const char* p = skip_ws(begin_, end_);
+        bool ret = false;
+        if (p < end_ and *p == '{') {
+            ret = parse_object(p, handler);
+        } else if (p < end_ and *p == '[') {
+            ret = parse_array(p, handler);
+        } else {
+            ret = parse_scalar(p, handler);
+        }
+        if (ret) {
+            p = skip_ws(p, end_);
+            succeeded_ = p == end_ or *p == '\0';
+        }
+        return succeeded_;
+    }
+
+    bool succeeded() const { return succeeded_; }
+
+private:
+    template <typename Handler>
+    bool parse_scalar(const char*& p, Handler& handler) {
+        rapidjson::MemoryStream is(p, end_ - p);
+        reader_.Parse<rapidjson::kParseStopWhenDoneFlag>(is, handler);
+        p += is.Tell();
+        return not reader_.HasParseError();
+    }
+
+    template <typename Handler>
+    bool parse_value(const char*& p, Handler& handler) {
+        if (p == end_ or (*p != '{' and *p != '[')) {
+            return parse_scalar(p, handler);
+        }
+        const char* last = skip_value(p, end_);
+        if (last == nullptr) {
+            return false;
+        }
+        LazyNode* node = static_cast<LazyNode*>(alloc_.Malloc(sizeof(LazyNode)));
+        node->magic = LazyNode::MAGIC;
+        node->self = node;
+        node->begin = p;
+        node->length = last - p;
+        p = last;
+        return handler.String(reinterpret_cast<const char*>(node), sizeof(LazyNode), false);
+    }
+
+    template <typename Handler>
+    bool parse_key(const char*& p, Handler& handler) {
+        const char* last = skip_string(p + 1, end_);
+        if (last == nullptr) {
+            return false;
+        }
+        const char* key = p + 1;
+        rapidjson::SizeType length = static_cast<rapidjson::SizeType>(last - 1 - key);
+        if (memchr(key, '\\', length) == nullptr) {
+            p = last;
+            return handler.Key(key, length, true);
+        }
+        // decode escapes
+        rapidjson::MemoryStream is(p, last - p);
+        KeyHandler<Handler> key_handler(handler);
+        reader_.Parse<rapidjson::kParseStopWhenDoneFlag>(is, key_handler);
+        p = last;
+        return not reader_.HasParseError();
+    }
+
+    template <typename Handler>
+    bool parse_object(const char*& p, Handler& handler) {
+        rapidjson::SizeType count = 0;
+        handler.StartObject();
+        p = skip_ws(p + 1, end_);
+        if (p < end_ and *p == '}') {
+            ++p;
+            return handler.EndObject(count);
+        }
+        while (p < end_ and *p == '"') {
+            if (not parse_key(p, handler)) {
+                return false;
+            }
+            p = skip_ws(p, end_);
+            if (p == end_ or *p != ':') {
+                return false;
+            }
+            p = skip_ws(p + 1, end_);
+            if (not parse_value(p, handler)) {
+                return false;
+            }
+            ++count;
+            p = skip_ws(p, end_);
+            if (p < end_ and *p == '}') {
+                ++p;
+                return handler.EndObject(count);
+            }
+            if (p == end_ or *p != ',') {
+                return false;
+            }
+            p = skip_ws(p + 1, end_);
+        }
+        return false;
+    }
+
+    template <typename Handler>
+    bool parse_array(const char*& p, Handler& handler) {
+        rapidjson::SizeType count = 0;
+        handler.StartArray();
+        p = skip_ws(p + 1, end_);
+        if (p < end_ and *p == ']') {
+            ++p;
+            return handler.EndArray(count);
+        }
+        while (p < end_) {
+            if (not parse_value(p, handler)) {
+                return false;
+            }
+            ++count;
+            p = skip_ws(p, end_);
+            if (p < end_ and *p == ']') {
+                ++p;
+                return handler.EndArray(count);
+            }
+            if (p == end_ or *p != ',') {
+                return false;
+            }
+            p = skip_ws(p + 1, end_);
+        }
+        return false;
+    }
+
+    template <typename Handler>
+    struct KeyHandler : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, KeyHandler<Handler>> {
+        explicit KeyHandler(Handler& handler) : handler(handler) {}
+        bool String(const char* str, rapidjson::SizeType length, bool copy) {
+            return handler.Key(str, length, copy);
+        }
+        Handler& handler;
+    };
+
+    const char*         begin_;
+    const char*         end_;
+    Allocator&          alloc_;
+    rapidjson::Reader   reader_;    // scalars and escaped keys
+    bool                succeeded_ = false;
+};
+
+/// replace a placeholder by its object or array ( one level, nested containers stay lazy ),
+/// false if its text is invalid ( the placeholder is kept )
+template <typename Allocator>
+inline bool materialize(rapidjson::GenericValue<rapidjson::UTF8<>, Allocator>& value, Allocator& alloc) {
+    const LazyNode* node = lazy_node(value);
+    if (node == nullptr) {
+        return true;
+    }
+    rapidjson::GenericDocument<rapidjson::UTF8<>, Allocator> level(&alloc);
+    LazyParser<Allocator> parser(node->begin, node->begin + node->length, alloc);
+    level.Populate(parser);
+    if (not parser.succeeded()) {
+        return false;
+    }
+    value.Swap(level);
+    return true;
+}
+
+/// replace a placeholder by its whole subtree ( for copies that outlive the LazyDocument )
+template <typename Allocator>
+inline bool parse_lazy(rapidjson::GenericValue<rapidjson::UTF8<>, Allocator>& value, const LazyNode& node, Allocator& alloc) {
+    rapidjson::GenericDocument<rapidjson::UTF8<>, Allocator> subtree(&alloc);
+    rapidjson::MemoryStream is(node.begin, node.length);
+    subtree.ParseStream(is);
+    if (subtree.HasParseError()) {
+        return false;
+    }
+    value.Swap(subtree);
+    return true;
+}
+
+/// parse every placeholder under value in full, false if one of them is invalid ( it is kept )
+template <typename Allocator>
+inline bool parse_all(rapidjson::GenericValue<rapidjson::UTF8<>, Allocator>& value, Allocator& alloc) {
+    const LazyNode* node = lazy_node(value);
+    if (node != nullptr) {
+        return parse_lazy(value, *node, alloc);
+    }
+    bool ret = true;
+    if (value.IsArray()) {
+        for (auto it = value.Begin(); it != value.End(); ++it) {
+            ret = parse_all(*it, alloc) and ret;
+        }
+    } else if (value.IsObject()) {
+        for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it) {
+            ret = parse_all(it->value, alloc) and ret;
+        }
+    }
+    return ret;
+}
+
+/// placeholders are only bracket matched at load, their text is validated before it is written raw
+inline bool lazy_valid(const LazyNode& node) {
+    rapidjson::MemoryStream is(node.begin, node.length);
+    rapidjson::BaseReaderHandler<> skip;
+    rapidjson::Reader reader;
+    return not reader.Parse(is, skip).IsError();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// writer handler that writes placeholders back as their source text
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Writer>
+class LazyWriter {
+public:
+    using Ch = char;
+    explicit LazyWriter(Writer& writer) : writer_(writer) {}
+
+    bool Null() { return writer_.Null(); }
+    bool Bool(bool b) { return writer_.Bool(b); }
+    bool Int(int i) { return writer_.Int(i); }
+    bool Uint(unsigned u) { return writer_.Uint(u); }
+    bool Int64(int64_t i) { return writer_.Int64(i); }
+    bool Uint64(uint64_t u) { return writer_.Uint64(u); }
+    bool Double(double d) { return writer_.Double(d); }
+    bool RawNumber(const Ch* str, rapidjson::SizeType length, bool copy) { return writer_.RawNumber(str, length, copy); }
+    bool String(const Ch* str, rapidjson::SizeType length, bool copy) {
+        const LazyNode* node = lazy_node(str, length);
+        if (node != nullptr) {
+            return lazy_valid(*node) and writer_.RawValue(node->begin, node->length,
+                    *node->begin == '{' ? rapidjson::kObjectType : rapidjson::kArrayType);
+        }
+        return writer_.String(str, length, copy);
+    }
+    bool StartObject() { return writer_.StartObject(); }
+    bool Key(const Ch* str, rapidjson::SizeType length, bool copy) { return writer_.Key(str, length, copy); }
+    bool EndObject(rapidjson::SizeType count) { return writer_.EndObject(count); }
+    bool StartArray() { return writer_.StartArray(); }
+    bool EndArray(rapidjson::SizeType count) { return writer_.EndArray(count); }
+
+private:
+    Writer& writer_;
+};
+
+/// value.Accept( writer ) with placeholders written as source text
+template <typename Value, typename Writer>
+inline bool accept(const Value& value, Writer& writer) {
+    LazyWriter<Writer> lazy_writer(writer);
+    return value.Accept(lazy_writer);
+}
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_LAZY_H_
@@ -0,0 +1,117 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_LINE_READER_H_
+#define WRAPIDJSON_LINE_READER_H_
+
+#include <string>
+#include <memory>
+#include <istream>
+#include <vector>
+#include <functional>
+
+#include "document.h"
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// JSON Lines ( NDJSON ) reader
+/// every record is parsed into the same arena, so the value of a record
+/// is valid only until the next call of next()
+/////////////////////////////////////////////////////////////////////////////////////////////
+class LineReader {
+    static const size_t ARENA_SIZE = 65536;
+public:
+    LineReader();
+    LineReader(const LineReader&) = delete;
+    LineReader& operator=(const LineReader&) = delete;
+    ~LineReader() = default;
+
+    /// set input ( the stream and the buffer must outlive the reader )
+    bool open_file(const std::string& path);
+    void open_stream(std::istream& is);
+    void open_buffer(const string_view& buffer);
+
+    /// move to the next non-empty line, false at the end of input
+    /// ( a malformed line is returned as well, check valid() )
+    bool next();
+
+    /// current record
+    bool valid() const;
+    size_t line() const;
+    ValueRef value();
+    std::string get_load_error();
+
+private:
+    bool read_line(string_view& line);
+
+    detail::Arena                       arena_;
+    rapidjson::Document                 document_;
+    std::unique_ptr<detail::MappedFile> mapped_;
+    std::istream*                       is_;
+    std::string                         line_buffer_;
+    const char*                         current_;
+    const char*                         end_;
+    size_t                              line_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// multi-threaded JSON Lines ( NDJSON ) reader
+/// the input is split into chunks at newlines, every worker parses its chunks into its own arena
+/// ( handlers are called from the worker threads, a record is valid only inside the handler )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ParallelLineReader {
+    static const size_t CHUNK_SIZE = 1 << 20;
+    static const size_t ARENA_SIZE = 65536;
+public:
+    using RecordHandler = std::function<void(size_t line, ValueRef record)>;
+    using ErrorHandler = std::function<void(size_t line, const std::string& error)>;
+
+    /// threads == 0 : std::thread::hardware_concurrency()
+    /// ordered : handlers are called one at a time in input order
+    ///           ( otherwise concurrently, in any order )
+    explicit ParallelLineReader(size_t threads = 0, bool ordered = false, size_t chunk_size = CHUNK_SIZE);
+
+    bool read_file(const std::string& path, const RecordHandler& on_record, const ErrorHandler& on_error = nullptr);
+    void read_buffer(const string_view& buffer, const RecordHandler& on_record, const ErrorHandler& on_error = nullptr);
+
+    size_t threads() const { return threads_; }
+    bool ordered() const { return ordered_; }
+
+private:
+    struct Chunk {
+        const char* begin;
+        const char* end;
+        size_t      first_line;
+    };
+    std::vector<Chunk> split(const string_view& buffer) const;
+
+    size_t  threads_;
+    bool    ordered_;
+    size_t  chunk_size_;
+};
+
+} // namespace wrapidjson
+
+#include "line_reader_impl.h"
+
+#endif // WRAPIDJSON_LINE_READER_H_
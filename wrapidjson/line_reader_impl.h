@@ -0,0 +1,289 @@
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <exception>
+
+namespace wrapidjson {
+namespace detail {
+
+inline std::string line_error(size_t line, const rapidjson::Document& document) {
+    return detail::format("Error line[%u] offset[%u]: %s",
+            (unsigned)line,
+            (unsigned)document.GetErrorOffset(),
+            rapidjson::GetParseError_En(document.GetParseError()));
+}
+
+/// call next( line_number, line ) for every non-empty line of [begin, end)
+template <typename Function>
+inline void for_each_line(const char* begin, const char* end, size_t first_line, Function next) {
+    size_t line_number = first_line;
+    while (begin != end) {
+        const char* nl = static_cast<const char*>(memchr(begin, '\n', end - begin));
+        const char* last = (nl != nullptr ? nl : end);
+        string_view line(begin, last - begin);
+        if (not line.empty() and line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.find_first_not_of(" \t") != string_view::npos) {
+            next(line_number, line);
+        }
+        ++line_number;
+        begin = (nl != nullptr ? nl + 1 : end);
+    }
+}
+
+/// run function( ) on threads and rethrow the first exception
+template <typename Function>
+inline void run_threads(size_t threads, Function function) {
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::vector<std::thread> workers;
+    workers.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+        workers.emplace_back([&]() {
+            try {
+                function();
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (not error) {
+                    error = std::current_exception();
+                }
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace detail
+
+inline LineReader::LineReader()
+    : arena_(ARENA_SIZE)
+    , document_(&arena_.allocator())
+    , is_(nullptr)
+    , current_(nullptr)
+    , end_(nullptr)
+    , line_(0)
+{}
+
+inline bool LineReader::open_file(const std::string& path) {
+    std::unique_ptr<detail::MappedFile> mapped(new detail::MappedFile());
+    if (not mapped->open(path)) {
+        return false;
+    }
+    mapped->advise(MADV_SEQUENTIAL);
+    open_buffer(string_view(mapped->data(), mapped->size()));
+    mapped_ = std::move(mapped);
+    return true;
+}
+
+inline void LineReader::open_stream(std::istream& is) {
+    mapped_.reset();
+    is_ = &is;
+    current_ = end_ = nullptr;
+    line_ = 0;
+}
+
+inline void LineReader::open_buffer(const string_view& buffer) {
+    mapped_.reset();
+    is_ = nullptr;
+    current_ = buffer.data();
+    end_ = buffer.data() + buffer.size();
+    line_ = 0;
+}
+
+inline bool LineReader::read_line(string_view& line) {
+    if (is_ != nullptr) {
+        if (not std::getline(*is_, line_buffer_)) {
+            return false;
+        }
+        line = string_view(line_buffer_.data(), line_buffer_.size());
+    } else {
+        if (current_ == end_) {
+            return false;
+        }
+        const char* nl = static_cast<const char*>(memchr(current_, '\n', end_ - current_));
+        const char* last = (nl != nullptr ? nl : end_);
+        line = string_view(current_, last - current_);
+        current_ = (nl != nullptr ? nl + 1 : end_);
+    }
+    if (not line.empty() and line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    ++line_;
+    return true;
+}
+
+inline bool LineReader::next() {
+    string_view line;
+    do {
+        if (not read_line(line)) {
+            document_.SetNull();
+            return false;
+        }
+    } while (line.find_first_not_of(" \t") == string_view::npos);
+
+    document_.SetNull();
+    arena_.rewind();    // reuse the block of the previous record
+    rapidjson::MemoryStream is(line.data(), line.size());
+    document_.ParseStream(is);
+    return true;
+}
+
+inline bool LineReader::valid() const {
+    return not document_.HasParseError();
+}
+
+inline size_t LineReader::line() const {
+    return line_;
+}
+
+inline ValueRef LineReader::value() {
+    return ValueRef(document_, arena_.allocator());
+}
+
+inline std::string LineReader::get_load_error() {
+    return detail::line_error(line_, document_);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// ParallelLineReader
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline ParallelLineReader::ParallelLineReader(size_t threads, bool ordered, size_t chunk_size)
+    : threads_(threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency()))
+    , ordered_(ordered)
+    , chunk_size_(chunk_size > 0 ? chunk_size : CHUNK_SIZE)
+{}
+
+inline bool ParallelLineReader::read_file(const std::string& path, const RecordHandler& on_record, const ErrorHandler& on_error) {
+    detail::MappedFile mapped;
+    if (not mapped.open(path)) {
+        return false;
+    }
+    read_buffer(string_view(mapped.data(), mapped.size()), on_record, on_error);
+    return true;
+}
+
+inline std::vector<ParallelLineReader::Chunk> ParallelLineReader::split(const string_view& buffer) const {
+    std::vector<Chunk> chunks;
+    const char* begin = buffer.data();
+    const char* end = buffer.data() + buffer.size();
+    while (begin != end) {
+        const char* last = end;
+        if (static_cast<size_t>(end - begin) > chunk_size_) {
+            const char* nl = static_cast<const char*>(memchr(begin + chunk_size_, '\n', end - begin - chunk_size_));
+            last = (nl != nullptr ? nl + 1 : end);
+        }
+        chunks.push_back(Chunk{begin, last, 0});
+        begin = last;
+    }
+    return chunks;
+}
+
+inline void ParallelLineReader::read_buffer(const string_view& buffer, const RecordHandler& on_record, const ErrorHandler& on_error) {
+    std::vector<Chunk> chunks = split(buffer);
+    size_t threads = std::min(threads_, chunks.size());
+    if (threads == 0) {
+        return;
+    }
+
+    // line numbers: count newlines of every chunk in parallel
+    std::vector<size_t> newlines(chunks.size());
+    std::atomic<size_t> next(0);
+    detail::run_threads(threads, [&]() {
+        for (size_t i = next++; i < chunks.size(); i = next++) {
+            newlines[i] = std::count(chunks[i].begin, chunks[i].end, '\n');
+        }
+    });
+    size_t first_line = 1;
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        chunks[i].first_line = first_line;
+        first_line += newlines[i];
+    }
+
+    // parse
+    std::mutex mutex;
+    std::condition_variable turn_changed;
+    size_t turn = 0;            // ordered : chunk allowed to call the handlers
+    std::atomic<bool> stop(false);
+    next = 0;
+
+    struct Entry {
+        size_t      line;
+        size_t      index;      // record index, NO_RECORD for error
+        std::string error;
+    };
+    const size_t NO_RECORD = static_cast<size_t>(-1);
+
+    detail::run_threads(threads, [&]() {
+        detail::Arena arena(ARENA_SIZE);
+        rapidjson::Document document(&arena.allocator());
+        std::vector<Entry> entries;
+        try {
+            for (size_t i = next++; i < chunks.size() and not stop; i = next++) {
+                const Chunk& chunk = chunks[i];
+                if (not ordered_) {
+                    detail::for_each_line(chunk.begin, chunk.end, chunk.first_line, [&](size_t line, const string_view& text) {
+                        document.SetNull();
+                        arena.rewind();
+                        rapidjson::MemoryStream is(text.data(), text.size());
+                        document.ParseStream(is);
+                        if (not document.HasParseError()) {
+                            on_record(line, ValueRef(document, arena.allocator()));
+                        } else if (on_error) {
+                            on_error(line, detail::line_error(line, document));
+                        }
+                    });
+                    continue;
+                }
+
+                // ordered : keep the whole chunk in the arena until its turn
+                entries.clear();
+                document.SetNull();
+                arena.rewind();
+                rapidjson::Value records(rapidjson::kArrayType);
+                detail::for_each_line(chunk.begin, chunk.end, chunk.first_line, [&](size_t line, const string_view& text) {
+                    rapidjson::MemoryStream is(text.data(), text.size());
+                    document.ParseStream(is);
+                    if (not document.HasParseError()) {
+                        entries.push_back(Entry{line, records.Size(), std::string()});
+                        records.PushBack(document.Move(), arena.allocator());
+                    } else {
+                        entries.push_back(Entry{line, NO_RECORD, detail::line_error(line, document)});
+                    }
+                });
+
+                std::unique_lock<std::mutex> lock(mutex);
+                turn_changed.wait(lock, [&]() { return turn == i or stop; });
+                if (stop) {
+                    break;
+                }
+                lock.unlock();
+                for (const auto& entry : entries) {
+                    if (entry.index != NO_RECORD) {
+                        on_record(entry.line, ValueRef(records[static_cast<rapidjson::SizeType>(entry.index)], arena.allocator()));
+                    } else if (on_error) {
+                        on_error(entry.line, entry.error);
+                    }
+                }
+                lock.lock();
+                ++turn;
+                turn_changed.notify_all();
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            stop = true;
+            turn_changed.notify_all();
+            throw;
+        }
+    });
+}
+
+} // namespace wrapidjson
@@ -0,0 +1,80 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_LINE_WRITER_H_
+#define WRAPIDJSON_LINE_WRITER_H_
+
+#include <string>
+
+#include <rapidjson/writer.h>
+
+#include "document.h"
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// JSON Lines ( NDJSON ) writer
+/// records are appended to one reusable buffer and written to the fd in large batches
+/////////////////////////////////////////////////////////////////////////////////////////////
+class LineWriter {
+    static const size_t FLUSH_SIZE = 1 << 20;
+public:
+    explicit LineWriter(size_t flush_size = FLUSH_SIZE);
+    LineWriter(const LineWriter&) = delete;
+    LineWriter& operator=(const LineWriter&) = delete;
+    ~LineWriter();
+
+    /// set output ( closes the previous one, records it failed to take are kept for the new one )
+    bool open_file(const std::string& path, bool append = false);
+    /// the fd is not closed by the writer
+    bool open_fd(int fd);
+    bool close();
+
+    /// append one record, written out when the buffer reaches the flush size
+    /// ( false only if the record cannot be serialized, it is not buffered then )
+    bool write(const ValueRef& value);
+    /// write out every buffered record
+    bool flush();
+    /// false once writing out failed, the records are kept for the next flush()
+    bool good() const { return not failed_; }
+
+    size_t flush_size() const { return flush_size_; }
+    void set_flush_size(size_t flush_size) { flush_size_ = flush_size; }
+    size_t buffered() const { return buffer_.size(); }
+
+private:
+    using OStreamType = BufferOStream<std::string>;
+
+    std::string                     buffer_;
+    OStreamType                     os_;
+    rapidjson::Writer<OStreamType>  writer_;
+    size_t                          flush_size_;
+    int                             fd_;
+    bool                            own_fd_;
+    bool                            failed_;
+};
+
+} // namespace wrapidjson
+
+#include "line_writer_impl.h"
+
+#endif // WRAPIDJSON_LINE_WRITER_H_
@@ -0,0 +1,93 @@
+#include <cerrno>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace wrapidjson {
+
+inline LineWriter::LineWriter(size_t flush_size)
+    : os_(buffer_)
+    , writer_(os_)
+    , flush_size_(flush_size)
+    , fd_(-1)
+    , own_fd_(false)
+    , failed_(false)
+{
+    buffer_.reserve(flush_size_ + flush_size_ / 4);
+}
+
+inline LineWriter::~LineWriter() {
+    close();
+}
+
+inline bool LineWriter::open_file(const std::string& path, bool append) {
+    close();
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC | (append ? O_APPEND : O_TRUNC), 0644);
+    if (fd < 0) {
+        return false;
+    }
+    fd_ = fd;
+    own_fd_ = true;
+    return true;
+}
+
+inline bool LineWriter::open_fd(int fd) {
+    close();
+    fd_ = fd;
+    own_fd_ = false;
+    return fd_ >= 0;
+}
+
+inline bool LineWriter::close() {
+    bool ret = flush();
+    if (own_fd_ and fd_ >= 0) {
+        ret = (::close(fd_) == 0) and ret;
+    }
+    fd_ = -1;
+    own_fd_ = false;
+    return ret;
+}
+
+inline bool LineWriter::write(const ValueRef& value) {
+    size_t mark = buffer_.size();
+    writer_.Reset(os_);
+    if (not value.get_rvalue().Accept(writer_)) {
+        buffer_.resize(mark);   // drop the partial record
+        return false;
+    }
+    buffer_.push_back('\n');
+    if (buffer_.size() >= flush_size_) {
+        flush();    // the record is accepted either way, a failure is reported by good()
+    }
+    return true;
+}
+
+inline bool LineWriter::flush() {
+    failed_ = false;
+    if (buffer_.empty()) {
+        return true;
+    }
+    if (fd_ < 0) {
+        failed_ = true;
+        return false;
+    }
+    const char* data = buffer_.data();
+    size_t remain = buffer_.size();
+    while (remain > 0) {
+        ssize_t n = ::write(fd_, data, remain);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            buffer_.erase(0, buffer_.size() - remain);  // keep what is not written yet
+            failed_ = true;
+            return false;
+        }
+        data += n;
+        remain -= static_cast<size_t>(n);
+    }
+    buffer_.clear();    // keeps capacity
+    return true;
+}
+
+} // namespace wrapidjson
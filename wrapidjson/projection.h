@@ -0,0 +1,69 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_PROJECTION_H_
+#define WRAPIDJSON_PROJECTION_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <initializer_list>
+
+#include <rapidjson/reader.h>
+#include <rapidjson/memorystream.h>
+
+#include "value_ref.h"
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Projection : the set of paths Document::load_from_buffer materializes
+/// paths are JSON Pointers ( "/user/name", "/items/0" ) or nested key lists,
+/// numeric keys also select array elements
+/////////////////////////////////////////////////////////////////////////////////////////////
+class Projection {
+public:
+    Projection() = default;
+    Projection(std::initializer_list<std::string> pointers);
+
+    /// JSON Pointer ( RFC 6901 ), "" selects the whole document
+    Projection& add(const std::string& pointer);
+    Projection& add(const std::vector<std::string>& keys);
+
+    bool empty() const { return not root_.all and root_.children.empty(); }
+
+    struct Node {
+        const Node* find(const string_view& key) const;
+        std::vector<std::pair<std::string, Node>> children;   // few keys, linear lookup without allocation
+        bool all = false;                                     // whole subtree selected
+    };
+    const Node& root() const { return root_; }
+
+private:
+    Node root_;
+};
+
+} // namespace wrapidjson
+
+#include "projection_impl.h"
+
+#endif // WRAPIDJSON_PROJECTION_H_
@@ -0,0 +1,270 @@
+#include <stdexcept>
+
+#include "scan.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/// JSON Pointer ( RFC 6901 ) to unescaped keys, false if it does not start with '/'
+inline bool split_pointer(const std::string& pointer, std::vector<std::string>& keys) {
+    keys.clear();
+    for (size_t pos = 0; pos < pointer.size(); ) {
+        if (pointer[pos] != '/') {
+            return false;
+        }
+        size_t next = pointer.find('/', pos + 1);
+        if (next == std::string::npos) {
+            next = pointer.size();
+        }
+        std::string key;
+        for (size_t i = pos + 1; i < next; ++i) {
+            if (pointer[i] == '~' and i + 1 < next and (pointer[i + 1] == '0' or pointer[i + 1] == '1')) {
+                key += pointer[++i] == '0' ? '~' : '/';
+            } else {
+                key += pointer[i];
+            }
+        }
+        keys.push_back(std::move(key));
+        pos = next;
+    }
+    return true;
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Projection
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline Projection::Projection(std::initializer_list<std::string> pointers) {
+    for (auto& pointer : pointers) {
+        add(pointer);
+    }
+}
+
+inline Projection& Projection::add(const std::string& pointer) {
+    std::vector<std::string> keys;
+    if (not detail::split_pointer(pointer, keys)) {
+        throw std::runtime_error("invalid JSON Pointer: " + pointer);
+    }
+    return add(keys);
+}
+
+inline Projection& Projection::add(const std::vector<std::string>& keys) {
+    Node* node = &root_;
+    for (auto& key : keys) {
+        if (node->all) {
+            return *this;   // already covered by a shorter path
+        }
+        Node* child = const_cast<Node*>(node->find(key));
+        if (child == nullptr) {
+            node->children.emplace_back(key, Node());
+            child = &node->children.back().second;
+        }
+        node = child;
+    }
+    node->all = true;
+    node->children.clear();
+    return *this;
+}
+
+inline const Projection::Node* Projection::Node::find(const string_view& key) const {
+    for (auto& child : children) {
+        if (key == child.first) {
+            return &child.second;
+        }
+    }
+    return nullptr;
+}
+
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Document::Populate generator: builds only the projected paths
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <unsigned ParseFlags = rapidjson::kParseDefaultFlags>
+class ProjectionParser {
+public:
+    ProjectionParser(const string_view& buffer, const Projection& projection)
+        : begin_(buffer.data()), end_(buffer.data() + buffer.size()), projection_(projection) {}
+
+    template <typename Handler>
+    bool operator()(Handler& handler) {
+        const char* p = skip_ws(begin_);
+        if (walk(p, projection_.root(), handler)) {
+            p = skip_ws(p);
+            succeeded_ = p == end_ or *p == '\0';
+        }
+        return succeeded_;
+    }
+
+    bool succeeded() const { return succeeded_; }
+
+private:
+    const char* skip_ws(const char* p) const {
+        return detail::skip_ws(p, end_);
+    }
+
+    /// p is moved past the value
+    template <typename Handler>
+    bool walk(const char*& p, const Projection::Node& node, Handler& handler) {
+        if (node.all or p == end_ or (*p != '{' and *p != '[')) {
+            rapidjson::MemoryStream is(p, end_ - p);
+            reader_.Parse<ParseFlags | rapidjson::kParseStopWhenDoneFlag>(is, handler);
+            p += is.Tell();
+            return not reader_.HasParseError();
+        }
+        return *p == '{' ? walk_object(p, node, handler) : walk_array(p, node, handler);
+    }
+
+    template <typename Handler>
+    bool walk_object(const char*& p, const Projection::Node& node, Handler& handler) {
+        rapidjson::SizeType count = 0;
+        handler.StartObject();
+        p = skip_ws(p + 1);
+        if (p < end_ and *p == '}') {
+            ++p;
+            return handler.EndObject(count);
+        }
+        while (p < end_) {
+            if (*p != '"') {
+                return false;
+            }
+            const char* key = p + 1;
+            const char* key_end = skip_string(key, end_);
+            if (key_end == nullptr) {
+                return false;
+            }
+            string_view raw(key, key_end - 1 - key);
+            if (memchr(raw.data(), '\\', raw.size()) != nullptr) {
+                // decode escapes ( rare )
+                rapidjson::MemoryStream is(p, key_end - p);
+                KeyCapture capture;
+                if (reader_.Parse<rapidjson::kParseStopWhenDoneFlag>(is, capture).IsError()) {
+                    return false;
+                }
+                key_ = std::move(capture.key);
+                raw = key_;
+            }
+            p = skip_ws(key_end);
+            if (p == end_ or *p != ':') {
+                return false;
+            }
+            p = skip_ws(p + 1);
+
+            const Projection::Node* child = node.find(raw);
+            if (child != nullptr and (child->all or (p < end_ and (*p == '{' or *p == '[')))) {
+                handler.Key(raw.data(), static_cast<rapidjson::SizeType>(raw.size()), true);
+                if (not walk(p, *child, handler)) {
+                    return false;
+                }
+                ++count;
+            } else if ((p = skip_value(p, end_)) == nullptr) {
+                return false;
+            }
+
+            p = skip_ws(p);
+            if (p == end_) {
+                return false;
+            }
+            if (*p == '}') {
+                ++p;
+                return handler.EndObject(count);
+            }
+            if (*p != ',') {
+                return false;
+            }
+            p = skip_ws(p + 1);
+        }
+        return false;
+    }
+
+    /// skipped elements before the last selected index are kept as null so indices do not shift
+    template <typename Handler>
+    bool walk_array(const char*& p, const Projection::Node& node, Handler& handler) {
+        rapidjson::SizeType count = 0;
+        handler.StartArray();
+        p = skip_ws(p + 1);
+        if (p < end_ and *p == ']') {
+            ++p;
+            return handler.EndArray(count);
+        }
+        const size_t last = selected_end(node);
+        char digits[24];
+        for (size_t index = 0; p < end_; ++index) {
+            const Projection::Node* child = index < last ? node.find(format_index(index, digits)) : nullptr;
+            if (child != nullptr and (child->all or *p == '{' or *p == '[')) {
+                if (not walk(p, *child, handler)) {
+                    return false;
+                }
+                ++count;
+            } else {
+                if ((p = skip_value(p, end_)) == nullptr) {
+                    return false;
+                }
+                if (index < last) {
+                    handler.Null();
+                    ++count;
+                }
+            }
+
+            p = skip_ws(p);
+            if (p == end_) {
+                return false;
+            }
+            if (*p == ']') {
+                ++p;
+                return handler.EndArray(count);
+            }
+            if (*p != ',') {
+                return false;
+            }
+            p = skip_ws(p + 1);
+        }
+        return false;
+    }
+
+    /// one past the highest array index among the selected keys, 0 if none is numeric
+    static size_t selected_end(const Projection::Node& node) {
+        size_t end = 0;
+        for (auto& child : node.children) {
+            const std::string& key = child.first;
+            if (key.empty() or key.size() > 18 or (key[0] == '0' and key.size() > 1)
+                or key.find_first_not_of("0123456789") != std::string::npos) {
+                continue;
+            }
+            size_t index = std::stoull(key);
+            if (index >= end) {
+                end = index + 1;
+            }
+        }
+        return end;
+    }
+
+    static string_view format_index(size_t index, char (&digits)[24]) {
+        char* last = digits + sizeof(digits);
+        char* first = last;
+        do {
+            *--first = static_cast<char>('0' + index % 10);
+            index /= 10;
+        } while (index != 0);
+        return string_view(first, last - first);
+    }
+
+    struct KeyCapture : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, KeyCapture> {
+        bool String(const char* str, rapidjson::SizeType length, bool) {
+            key.assign(str, length);
+            return true;
+        }
+        std::string key;
+    };
+
+    const char*         begin_;
+    const char*         end_;
+    const Projection&   projection_;
+    rapidjson::Reader   reader_;    // parses the selected subtrees, stack reused
+    std::string         key_;
+    bool                succeeded_ = false;
+};
+
+} // namespace detail
+} // namespace wrapidjson
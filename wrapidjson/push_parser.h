@@ -0,0 +1,171 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_PUSH_PARSER_H_
+#define WRAPIDJSON_PUSH_PARSER_H_
+
+#include <string>
+#include <vector>
+
+#include <rapidjson/reader.h>
+
+#include "document.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// stream over the unconsumed tail of the previous chunks followed by the current chunk
+/// ( Tell() counts from the start of the input, Peek() is '\0' at the end of the fed bytes ),
+/// copies are cheap cursors for look-ahead
+/////////////////////////////////////////////////////////////////////////////////////////////
+class ChunkStream {
+public:
+    using Ch = char;
+    ChunkStream(const string_view& tail, const string_view& chunk, size_t offset);
+
+    Ch Peek() const { return current_ != end_ ? *current_ : '\0'; }
+    Ch Take();
+    size_t Tell() const { return offset_; }
+    /// every fed byte is consumed
+    bool empty() const { return current_ == end_; }
+    /// after an opening quote : move past the closing one, false if it is not fed yet
+    bool skip_string();
+
+    Ch* PutBegin() { throw std::runtime_error("ChunkStream::PutBegin not implement"); }
+    void Put(Ch) { throw std::runtime_error("ChunkStream::Put not implement"); }
+    void Flush() { throw std::runtime_error("ChunkStream::Flush not implement"); }
+    size_t PutEnd(Ch*) { throw std::runtime_error("ChunkStream::PutEnd not implement"); }
+
+private:
+    const Ch*   current_;
+    const Ch*   end_;
+    const Ch*   next_;
+    const Ch*   next_end_;
+    size_t      offset_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// handler building a value event by event ( GenericDocument only builds inside one Parse call )
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Allocator>
+class ValueBuilder {
+public:
+    using Ch = char;
+    using Value = rapidjson::GenericValue<rapidjson::UTF8<>, Allocator>;
+
+    explicit ValueBuilder(Allocator& allocator) : alloc_(allocator) {}
+
+    bool Null() { Value value; return add(value); }
+    bool Bool(bool b) { Value value(b); return add(value); }
+    bool Int(int i) { Value value(i); return add(value); }
+    bool Uint(unsigned u) { Value value(u); return add(value); }
+    bool Int64(int64_t i) { Value value(i); return add(value); }
+    bool Uint64(uint64_t u) { Value value(u); return add(value); }
+    bool Double(double d) { Value value(d); return add(value); }
+    bool RawNumber(const Ch* str, rapidjson::SizeType length, bool copy) { return String(str, length, copy); }
+    bool String(const Ch* str, rapidjson::SizeType length, bool) { Value value(str, length, alloc_); return add(value); }
+    bool StartObject() { Value value(rapidjson::kObjectType); return open(value); }
+    bool Key(const Ch* str, rapidjson::SizeType length, bool) { key_.SetString(str, length, alloc_); return true; }
+    bool EndObject(rapidjson::SizeType) { open_.pop_back(); return true; }
+    bool StartArray() { Value value(rapidjson::kArrayType); return open(value); }
+    bool EndArray(rapidjson::SizeType) { open_.pop_back(); return true; }
+
+    /// the root once it is complete
+    Value& root() { return root_; }
+
+private:
+    /// move value into the innermost open container ( or the root )
+    Value* append(Value& value);
+    bool add(Value& value) {
+        append(value);
+        return true;
+    }
+    bool open(Value& value) {
+        open_.push_back(append(value));     // only the innermost container grows, outer pointers stay valid
+        return true;
+    }
+
+    Allocator&          alloc_;
+    Value               root_;
+    Value               key_;
+    std::vector<Value*> open_;
+};
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// BasicPushParser ( builds a document from chunks as they arrive, e.g. from a socket )
+/// feed() runs rapidjson's iterative parser token by token ( IterativeParseNext, after rapidjson
+/// 1.1.0 ) over the chunk and returns once it is used up, no thread and no blocking, so it can be
+/// called from an event loop. Only the unconsumed tail of a token cut by the chunk end is copied
+/// until the next feed(). Results and errors are those of rapidjson's iterative parser over the
+/// whole input, the document is set at finish() ( at the end of the root with
+/// kParseStopWhenDoneFlag ) and keeps its previous value on failure. Values are allocated from
+/// the document, so it must not be loaded or reset while the parser is running
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename DocumentType = Document>
+class BasicPushParser {
+public:
+    explicit BasicPushParser(DocumentType& document);
+    BasicPushParser(const BasicPushParser&) = delete;
+    BasicPushParser& operator=(const BasicPushParser&) = delete;
+    /// unfinished input is abandoned ( the document is unchanged )
+    ~BasicPushParser() = default;
+
+    /// false on an error, or once the parser stopped ( an error, finish(), or the end of the root
+    /// with kParseStopWhenDoneFlag ), the caller may reuse the chunk when it returns
+    bool feed(const char* data, size_t size);
+    bool feed(const string_view& data);
+
+    /// end of input, true if the document is complete ( get_load_error() tells why not )
+    bool finish();
+    std::string get_load_error() const;
+
+private:
+    using Allocator = typename DocumentType::GenericDocument::AllocatorType;
+    static const unsigned ParseFlags = DocumentType::PARSE_FLAGS;
+
+    /// parse the complete tokens of is
+    void parse(detail::ChunkStream& is, bool last);
+    /// with the root complete, only whitespace may follow
+    void check_trailing(detail::ChunkStream& is, bool last);
+    void fail(rapidjson::ParseErrorCode code, size_t offset);
+    void done();
+
+    DocumentType&                   document_;
+    rapidjson::Reader               reader_;
+    detail::ValueBuilder<Allocator> builder_;
+    std::string                     tail_;          // unconsumed bytes of the current token
+    size_t                          offset_ = 0;    // input offset of tail_
+    rapidjson::ParseResult          result_;
+    bool                            complete_ = false;  // the root is parsed
+    bool                            stopped_ = false;
+};
+
+using PushParser = BasicPushParser<>;
+
+} // namespace wrapidjson
+
+#include "push_parser_impl.h"
+
+#endif // WRAPIDJSON_PUSH_PARSER_H_
@@ -0,0 +1,281 @@
+#include <stdexcept>
+
+#include <rapidjson/error/en.h>
+
+#include "scan.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// ChunkStream
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline ChunkStream::ChunkStream(const string_view& tail, const string_view& chunk, size_t offset)
+    : current_(tail.data())
+    , end_(tail.data() + tail.size())
+    , next_(chunk.data())
+    , next_end_(chunk.data() + chunk.size())
+    , offset_(offset)
+{
+    if (current_ == end_) {
+        current_ = next_;
+        end_ = next_end_;
+        next_ = next_end_;
+    }
+}
+
+inline ChunkStream::Ch ChunkStream::Take() {
+    if (current_ == end_) {
+        return '\0';
+    }
+    Ch c = *current_++;
+    ++offset_;
+    if (current_ == end_) {
+        current_ = next_;
+        end_ = next_end_;
+        next_ = next_end_;
+    }
+    return c;
+}
+
+inline bool ChunkStream::skip_string() {
+    for (;;) {
+        if (current_ == end_) {
+            return false;
+        }
+        if (next_ == next_end_) {
+            // last segment, no escape pending : search it at once
+            const Ch* last = detail::skip_string(current_, end_);
+            if (last == nullptr) {
+                return false;
+            }
+            offset_ += static_cast<size_t>(last - current_);
+            current_ = last;
+            return true;
+        }
+        Ch c = Take();
+        if (c == '"') {
+            return true;
+        }
+        if (c == '\\') {
+            if (current_ == end_) {
+                return false;
+            }
+            Take();
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// ValueBuilder
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Allocator>
+inline typename ValueBuilder<Allocator>::Value* ValueBuilder<Allocator>::append(Value& value) {
+    if (open_.empty()) {
+        root_ = value;
+        return &root_;
+    }
+    Value& parent = *open_.back();
+    if (parent.IsArray()) {
+        parent.PushBack(value, alloc_);
+        return &parent[parent.Size() - 1];
+    }
+    parent.AddMember(key_, value, alloc_);
+    return &(parent.MemberEnd() - 1)->value;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// look-ahead over the fed bytes, so IterativeParseNext never meets their end inside a token
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// numbers and literals ( true, NaN, ... ) end at the first other byte
+inline bool is_word(char c) {
+    return (c >= '0' and c <= '9') or (c >= 'a' and c <= 'z') or (c >= 'A' and c <= 'Z')
+        or c == '-' or c == '+' or c == '.';
+}
+
+/// skip whitespace ( and comments with kParseCommentsFlag ), false if the bytes end inside a
+/// comment ( last : at the end of input, where a // comment is complete as in rapidjson )
+template <unsigned ParseFlags>
+inline bool skip_space(ChunkStream& is, bool last = false) {
+    for (;;) {
+        char c = is.Peek();
+        if (c == ' ' or c == '\n' or c == '\r' or c == '\t') {
+            is.Take();
+        } else if ((ParseFlags & rapidjson::kParseCommentsFlag) != 0 and c == '/') {
+            ChunkStream start = is;
+            is.Take();
+            if (is.empty()) {
+                return false;
+            }
+            char kind = is.Take();
+            if (kind == '*') {
+                char prev = '\0';
+                for (char ch = '\0'; not (prev == '*' and ch == '/'); ) {
+                    if (is.empty()) {
+                        return false;
+                    }
+                    prev = ch;
+                    ch = is.Take();
+                }
+            } else if (kind == '/') {
+                while (is.Take() != '\n') {
+                    if (is.empty()) {
+                        return last;
+                    }
+                }
+            } else {
+                is = start;     // not a comment, the reader reports it
+                return true;
+            }
+        } else {
+            return true;
+        }
+    }
+}
+
+/// the next call of IterativeParseNext reads a token and the token after a ',' or ':', true if
+/// the fed bytes hold them in full
+template <unsigned ParseFlags>
+inline bool token_ready(ChunkStream is) {
+    for (int tokens = 0; tokens < 2; ++tokens) {
+        if (not skip_space<ParseFlags>(is) or is.empty()) {
+            return false;
+        }
+        char c = is.Take();
+        if (c == ',' or c == ':') {
+            continue;
+        }
+        if (c == '"') {
+            if (not is.skip_string()) {
+                return false;
+            }
+        } else if (is_word(c)) {
+            while (not is.empty() and is_word(is.Peek())) {
+                is.Take();
+            }
+            if (is.empty()) {
+                return false;
+            }
+        }
+        // at the end of the root the reader skips what follows
+        return (ParseFlags & rapidjson::kParseCommentsFlag) == 0 or skip_space<ParseFlags>(is);
+    }
+    return true;    // a second delimiter, the reader reports it
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// BasicPushParser
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename DocumentType>
+inline BasicPushParser<DocumentType>::BasicPushParser(DocumentType& document)
+    : document_(document)
+    , builder_(document.document_->GetAllocator())
+{
+    reader_.IterativeParseInit();
+}
+
+template <typename DocumentType>
+inline bool BasicPushParser<DocumentType>::feed(const char* data, size_t size) {
+    if (stopped_) {
+        return false;
+    }
+    detail::ChunkStream is(tail_, string_view(data, size), offset_);
+    parse(is, false);
+
+    // keep what is left of the token cut by the end of the chunk
+    size_t consumed = is.Tell() - offset_;
+    if (consumed < tail_.size()) {
+        tail_.erase(0, consumed);
+        tail_.append(data, size);
+    } else {
+        consumed -= tail_.size();
+        tail_.assign(data + consumed, size - consumed);
+    }
+    offset_ = is.Tell();
+    return not result_.IsError();
+}
+
+template <typename DocumentType>
+inline bool BasicPushParser<DocumentType>::feed(const string_view& data) {
+    return feed(data.data(), data.size());
+}
+
+template <typename DocumentType>
+inline bool BasicPushParser<DocumentType>::finish() {
+    if (not stopped_) {
+        detail::ChunkStream is(tail_, string_view(), offset_);
+        parse(is, true);
+        if (complete_ and not stopped_) {
+            done();     // neither failed nor set at the end of the root
+        }
+        stopped_ = true;
+    }
+    std::string().swap(tail_);
+    return complete_ and not result_.IsError();
+}
+
+template <typename DocumentType>
+inline std::string BasicPushParser<DocumentType>::get_load_error() const {
+    return detail::format("Error offset[%u]: %s",
+            (unsigned)result_.Offset(),
+            rapidjson::GetParseError_En(result_.Code()));
+}
+
+template <typename DocumentType>
+inline void BasicPushParser<DocumentType>::parse(detail::ChunkStream& is, bool last) {
+    while (not complete_) {
+        if (not last and not detail::token_ready<ParseFlags>(is)) {
+            return;
+        }
+        if (last) {
+            // trailing whitespace must reach the reader's end of input check, not its tokenizer
+            detail::ChunkStream rest = is;
+            if (detail::skip_space<ParseFlags>(rest, true)) {
+                is = rest;
+            }
+        }
+        if (not reader_.template IterativeParseNext<ParseFlags>(is, builder_)) {
+            fail(reader_.GetParseErrorCode(), reader_.GetErrorOffset());
+            return;
+        }
+        complete_ = reader_.IterativeParseComplete();
+    }
+    check_trailing(is, last);
+}
+
+template <typename DocumentType>
+inline void BasicPushParser<DocumentType>::check_trailing(detail::ChunkStream& is, bool last) {
+    if ((ParseFlags & rapidjson::kParseStopWhenDoneFlag) != 0) {
+        done();     // what follows the root is not read
+        stopped_ = true;
+        return;
+    }
+    detail::ChunkStream rest = is;
+    if (not detail::skip_space<ParseFlags>(rest, last)) {
+        if (last) {
+            fail(rapidjson::kParseErrorUnspecificSyntaxError, rest.Tell());     // unterminated comment
+        }
+        return;     // the comment is kept for the next chunk
+    }
+    is = rest;
+    if (not is.empty()) {
+        fail(rapidjson::kParseErrorDocumentRootNotSingular, is.Tell());
+    }
+}
+
+template <typename DocumentType>
+inline void BasicPushParser<DocumentType>::fail(rapidjson::ParseErrorCode code, size_t offset) {
+    result_.Set(code, offset);
+    stopped_ = true;
+}
+
+template <typename DocumentType>
+inline void BasicPushParser<DocumentType>::done() {
+    typename DocumentType::Value& value = *document_.document_;
+    value = builder_.root();    // moved, the previous value is released
+    document_.loaded(true);
+}
+
+} // namespace wrapidjson
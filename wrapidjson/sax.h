@@ -0,0 +1,93 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_SAX_H_
+#define WRAPIDJSON_SAX_H_
+
+#include <string>
+#include <istream>
+
+#include <rapidjson/reader.h>
+
+#include "document.h"
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SAX handler base
+/// derive and hide the callbacks you need ( handlers are called without virtual dispatch ),
+/// return false to stop parsing, string_view arguments are valid only inside the callback
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct SaxHandler {
+    bool on_null() { return true; }
+    bool on_bool(bool) { return true; }
+    bool on_int64(int64_t) { return true; }
+    bool on_uint64(uint64_t) { return true; }   // only for values over INT64_MAX
+    bool on_double(double) { return true; }
+    bool on_string(string_view) { return true; }
+    bool on_key(string_view) { return true; }
+    bool on_start_object() { return true; }
+    bool on_end_object(size_t) { return true; }
+    bool on_start_array() { return true; }
+    bool on_end_array(size_t) { return true; }
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SAX reader ( rapidjson::Reader without DOM, same sources as Document )
+/// ParseFlags : rapidjson::ParseFlag as BasicDocument ( kParseInsituFlag is chosen by the loader )
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <unsigned ParseFlags = rapidjson::kParseDefaultFlags>
+class BasicSaxReader {
+    static_assert((ParseFlags & rapidjson::kParseInsituFlag) == 0, "in-situ parsing is chosen by the loader");
+
+    static const size_t BUFFER_SIZE = detail::BUFFER_SIZE;
+public:
+    BasicSaxReader() = default;
+    BasicSaxReader(const BasicSaxReader&) = delete;
+    BasicSaxReader& operator=(const BasicSaxReader&) = delete;
+
+    template <typename Handler>
+    bool load_from_file(const std::string& path, Handler& handler);
+    /// in-situ parse of a private mapping ( strings are not copied )
+    template <typename Handler>
+    bool load_from_mmap(const std::string& path, Handler& handler);
+    template <typename Handler>
+    bool load_from_buffer(const string_view& buffer, Handler& handler);
+    template <typename Handler>
+    bool load_from_stream(std::istream& is, Handler& handler);
+    std::string get_load_error();
+
+private:
+    template <unsigned Flags, typename InputStream, typename Handler>
+    bool parse(InputStream& is, Handler& handler);
+
+    rapidjson::Reader       reader_;    // keeps its stack between documents
+    rapidjson::ParseResult  result_;
+};
+
+using SaxReader = BasicSaxReader<>;
+
+} // namespace wrapidjson
+
+#include "sax_impl.h"
+
+#endif // WRAPIDJSON_SAX_H_
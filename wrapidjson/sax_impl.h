@@ -0,0 +1,98 @@
+#include <cstdio>
+#include <limits>
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// rapidjson handler to SaxHandler
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Handler>
+class SaxAdapter {
+public:
+    using Ch = char;
+    explicit SaxAdapter(Handler& handler) : handler_(handler) {}
+
+    bool Null() { return handler_.on_null(); }
+    bool Bool(bool b) { return handler_.on_bool(b); }
+    bool Int(int i) { return handler_.on_int64(i); }
+    bool Uint(unsigned u) { return handler_.on_int64(u); }
+    bool Int64(int64_t i) { return handler_.on_int64(i); }
+    bool Uint64(uint64_t u) {
+        if (u <= static_cast<uint64_t>(std::numeric_limits<int64_t>::max())) {
+            return handler_.on_int64(static_cast<int64_t>(u));
+        }
+        return handler_.on_uint64(u);
+    }
+    bool Double(double d) { return handler_.on_double(d); }
+    bool RawNumber(const Ch* str, rapidjson::SizeType length, bool) { return handler_.on_string(string_view(str, length)); }
+    bool String(const Ch* str, rapidjson::SizeType length, bool) { return handler_.on_string(string_view(str, length)); }
+    bool StartObject() { return handler_.on_start_object(); }
+    bool Key(const Ch* str, rapidjson::SizeType length, bool) { return handler_.on_key(string_view(str, length)); }
+    bool EndObject(rapidjson::SizeType count) { return handler_.on_end_object(count); }
+    bool StartArray() { return handler_.on_start_array(); }
+    bool EndArray(rapidjson::SizeType count) { return handler_.on_end_array(count); }
+
+private:
+    Handler& handler_;
+};
+
+} // namespace detail
+
+template <unsigned ParseFlags>
+template <unsigned Flags, typename InputStream, typename Handler>
+inline bool BasicSaxReader<ParseFlags>::parse(InputStream& is, Handler& handler) {
+    detail::SaxAdapter<Handler> adapter(handler);
+    result_ = reader_.template Parse<Flags>(is, adapter);
+    return not result_.IsError();
+}
+
+template <unsigned ParseFlags>
+template <typename Handler>
+inline bool BasicSaxReader<ParseFlags>::load_from_file(const std::string& path, Handler& handler) {
+    FILE* fp = fopen(path.c_str(), "r");
+    if (fp == nullptr) {
+        return false;
+    }
+
+    char    readBuffer[BUFFER_SIZE];
+    rapidjson::FileReadStream is(fp, readBuffer, BUFFER_SIZE);
+    bool ret = parse<ParseFlags>(is, handler);
+    fclose(fp);
+    return ret;
+}
+
+template <unsigned ParseFlags>
+template <typename Handler>
+inline bool BasicSaxReader<ParseFlags>::load_from_mmap(const std::string& path, Handler& handler) {
+    detail::MappedFile mapped;
+    if (not mapped.open(path)) {
+        return false;
+    }
+    mapped.advise(MADV_SEQUENTIAL);
+    InsituStream is(mapped.data(), mapped.size());
+    return parse<ParseFlags | rapidjson::kParseInsituFlag>(is, handler);
+}
+
+template <unsigned ParseFlags>
+template <typename Handler>
+inline bool BasicSaxReader<ParseFlags>::load_from_buffer(const string_view& buffer, Handler& handler) {
+    rapidjson::MemoryStream is(buffer.data(), buffer.size());
+    return parse<ParseFlags>(is, handler);
+}
+
+template <unsigned ParseFlags>
+template <typename Handler>
+inline bool BasicSaxReader<ParseFlags>::load_from_stream(std::istream& is, Handler& handler) {
+    IStream is_wrapper(is, BUFFER_SIZE);
+    return parse<ParseFlags>(is_wrapper, handler);
+}
+
+template <unsigned ParseFlags>
+inline std::string BasicSaxReader<ParseFlags>::get_load_error() {
+    return detail::format("Error offset[%u]: %s",
+            (unsigned)result_.Offset(),
+            rapidjson::GetParseError_En(result_.Code()));
+}
+
+} // namespace wrapidjson
@@ -0,0 +1,102 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_SCAN_H_
+#define WRAPIDJSON_SCAN_H_
+
+#include <cstring>
+
+namespace wrapidjson {
+namespace detail {
+
+inline const char* skip_ws(const char* p, const char* end) {
+    while (p < end and (*p == ' ' or *p == '\n' or *p == '\r' or *p == '\t')) {
+        ++p;
+    }
+    return p;
+}
+
+/// p points after the opening quote, returns the position after the closing quote
+inline const char* skip_string(const char* p, const char* end) {
+    while (p < end) {
+        const char* quote = static_cast<const char*>(memchr(p, '"', end - p));
+        if (quote == nullptr) {
+            return nullptr;
+        }
+        // an odd run of backslashes escapes the quote
+        const char* q = quote;
+        while (q > p and q[-1] == '\\') {
+            --q;
+        }
+        if (((quote - q) & 1) == 0) {
+            return quote + 1;
+        }
+        p = quote + 1;
+    }
+    return nullptr;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// skip one JSON value by matching brackets and quotes ( no allocation, no validation )
+/// returns the position after the value or nullptr if it is not terminated
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline const char* skip_value(const char* p, const char* end) {
+    if (p == end) {
+        return nullptr;
+    }
+    if (*p == '"') {
+        return skip_string(p + 1, end);
+    }
+    if (*p != '{' and *p != '[') {
+        while (p < end and *p != ',' and *p != '}' and *p != ']'
+               and *p != ' ' and *p != '\n' and *p != '\r' and *p != '\t') {
+            ++p;
+        }
+        return p;
+    }
+    size_t depth = 0;
+    while (p < end) {
+        switch (*p) {
+        case '"':
+            p = skip_string(p + 1, end);
+            if (p == nullptr) {
+                return nullptr;
+            }
+            continue;
+        case '{': case '[':
+            ++depth;
+            break;
+        case '}': case ']':
+            if (--depth == 0) {
+                return p + 1;
+            }
+            break;
+        }
+        ++p;
+    }
+    return nullptr;
+}
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_SCAN_H_
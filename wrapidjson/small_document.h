@@ -0,0 +1,114 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_SMALL_DOCUMENT_H_
+#define WRAPIDJSON_SMALL_DOCUMENT_H_
+
+#include <string>
+
+#include "document.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// inline buffers of SmallDocument ( a base so they are built before the ValueRef base )
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <size_t N>
+struct SmallStorage {
+    /// stack blocks hold at least rapidjson's initial reader ( 256 bytes ) and writer
+    /// ( 32 levels ) stacks
+    static const size_t STACK = N / 2 < 512 ? 512 : N / 2;
+
+    using StackAllocator = InlineStackAllocator<STACK>;
+    using GenericDocument = rapidjson::GenericDocument<rapidjson::UTF8<>, rapidjson::MemoryPoolAllocator<>, StackAllocator>;
+
+    SmallStorage()
+        : pool_(buffer_, N)
+        , document_(&pool_, STACK, &stack_) {}
+
+    alignas(16) char                    buffer_[N];
+    rapidjson::MemoryPoolAllocator<>    pool_;
+    StackAllocator                      stack_;
+    GenericDocument                     document_;
+};
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SmallDocument ( document that lives in place, e.g. on the stack, for small messages )
+/// values are allocated from an inline N bytes pool and the parse and write stacks from two
+/// inline N / 2 bytes ( at least 512 ) blocks, the heap is used only when a message overflows them,
+/// not copyable or movable since ValueRefs point into the object
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <size_t N = 1024>
+class SmallDocument : private detail::SmallStorage<N>, public ValueRef {
+    static_assert(N >= 256, "inline buffer is too small for the pool header");
+
+    using Storage = detail::SmallStorage<N>;
+    using StackAllocator = typename Storage::StackAllocator;
+
+    template <typename OutputStream>
+    using Writer = rapidjson::Writer<OutputStream, rapidjson::UTF8<>, rapidjson::UTF8<>, StackAllocator>;
+    template <typename OutputStream>
+    using PrettyWriter = rapidjson::PrettyWriter<OutputStream, rapidjson::UTF8<>, rapidjson::UTF8<>, StackAllocator>;
+public:
+    using typename Storage::GenericDocument;
+
+    SmallDocument();
+    explicit SmallDocument(const std::string&);
+    SmallDocument(const SmallDocument&) = delete;
+    SmallDocument& operator=(const SmallDocument&) = delete;
+
+    ~SmallDocument() override = default;
+
+    /// load JSON data ( the inline pool is rewound first, so unlike Document a failed load
+    /// does not keep the previous document, it leaves null )
+    bool load_from_buffer(const std::string& buffer);
+    bool load_from_buffer(const char* buffer);
+    bool load_from_buffer(const string_view& buffer);
+    std::string get_load_error();
+
+    /// set to null and give the overflow chunks back to the heap
+    void reset();
+
+    /// save JSON data
+    bool save_to_buffer(std::string& buffer, bool pretty = false);
+    /// write straight into buffer ( cleared first, capacity reused )
+    template <typename Buffer>
+    bool save_to_buffer(Buffer& buffer, bool pretty = false);
+
+    /// get the actual rapidjson::GenericDocument by reference
+    inline GenericDocument& get_document() {
+        return this->document_;
+    }
+
+private:
+    template <typename InputStream>
+    bool load_from_stream(InputStream& is);
+};
+
+} // namespace wrapidjson
+
+#include "small_document_impl.h"
+
+#endif // WRAPIDJSON_SMALL_DOCUMENT_H_
@@ -0,0 +1,86 @@
+#include <rapidjson/memorystream.h>
+#include <rapidjson/error/en.h>
+
+namespace wrapidjson {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SmallDocument::SmallDocument
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <size_t N>
+inline SmallDocument<N>::SmallDocument()
+    : Storage()
+    , ValueRef(this->document_, this->pool_)
+{}
+
+template <size_t N>
+inline SmallDocument<N>::SmallDocument(const std::string& buffer)
+    : SmallDocument()
+{
+    load_from_buffer(buffer);
+}
+
+/// load JSON data
+template <size_t N>
+inline bool SmallDocument<N>::load_from_buffer(const std::string& buffer) {
+    return load_from_buffer(string_view(buffer));
+}
+
+template <size_t N>
+inline bool SmallDocument<N>::load_from_buffer(const char* buffer) {
+    rapidjson::StringStream is(buffer);
+    return load_from_stream(is);
+}
+
+template <size_t N>
+inline bool SmallDocument<N>::load_from_buffer(const string_view& buffer) {
+    rapidjson::MemoryStream is(buffer.data(), buffer.size());
+    return load_from_stream(is);
+}
+
+template <size_t N>
+template <typename InputStream>
+inline bool SmallDocument<N>::load_from_stream(InputStream& is) {
+    reset();    // the pool is rewound before parsing, a failed parse leaves null
+    this->document_.ParseStream(is);
+    return not this->document_.HasParseError();
+}
+
+template <size_t N>
+inline std::string SmallDocument<N>::get_load_error() {
+    return detail::format("Error offset[%u]: %s",
+            (unsigned)this->document_.GetErrorOffset(),
+            rapidjson::GetParseError_En(this->document_.GetParseError()));
+}
+
+template <size_t N>
+inline void SmallDocument<N>::reset() {
+    this->document_.SetNull();
+    this->pool_.Clear();
+}
+
+/// save JSON data
+template <size_t N>
+inline bool SmallDocument<N>::save_to_buffer(std::string& buffer, bool pretty) {
+    return save_to_buffer<std::string>(buffer, pretty);
+}
+
+template <size_t N>
+template <typename Buffer>
+inline bool SmallDocument<N>::save_to_buffer(Buffer& buffer, bool pretty) {
+    buffer.clear();     // keeps capacity for the next document
+    BufferOStream<Buffer> os(buffer);
+    bool ret = false;
+    if (pretty) {
+        PrettyWriter<BufferOStream<Buffer>> writer(os, &this->stack_);
+        ret = this->document_.Accept(writer);
+    } else {
+        Writer<BufferOStream<Buffer>> writer(os, &this->stack_);
+        ret = this->document_.Accept(writer);
+    }
+    if (not ret) {
+        buffer.clear();
+    }
+    return ret;
+}
+
+} // namespace wrapidjson
@@ -0,0 +1,208 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_SNAPSHOT_H_
+#define WRAPIDJSON_SNAPSHOT_H_
+
+#include <string>
+#include <memory>
+#include <utility>
+
+#include "document.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// sections of a mapped snapshot
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct SnapshotSections {
+    const char*     strings = nullptr;
+    uint64_t        strings_size = 0;
+    const char*     tree = nullptr;
+    uint64_t        tree_size = 0;
+    const char*     keys = nullptr;
+    uint64_t        keys_size = 0;
+    const char*     index = nullptr;
+    uint64_t        key_count = 0;
+};
+
+} // namespace detail
+
+class SnapshotRef;
+struct SnapshotMember;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// Iterator over array elements / object members of a snapshot
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <typename NodeType, typename ReferenceType>
+class SnapshotIterator : public std::iterator<std::forward_iterator_tag, ReferenceType, ptrdiff_t, const ReferenceType*, ReferenceType> {
+public:
+    SnapshotIterator(const detail::SnapshotSections& sections, const NodeType* ptr)
+        : sections_(&sections), ptr_(ptr) {}
+
+    SnapshotIterator& operator++(){ ++ptr_; return *this; }                                 // ++itr
+    SnapshotIterator  operator++(int){ SnapshotIterator old(*this); ++ptr_; return old; }   // itr++
+
+    bool operator==(const SnapshotIterator& rfs) const { return ptr_ == rfs.ptr_; }
+    bool operator!=(const SnapshotIterator& rfs) const { return ptr_ != rfs.ptr_; }
+
+    ReferenceType operator*() const;
+    ReferenceType operator->() const { return operator*(); }
+
+private:
+    const detail::SnapshotSections* sections_;
+    const NodeType*                 ptr_;
+};
+
+using SnapshotValueIterator = SnapshotIterator<detail::SnapshotNode, SnapshotRef>;
+using SnapshotMemberIterator = SnapshotIterator<detail::SnapshotMember, SnapshotMember>;
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SnapshotRef ( read-only value of a SnapshotDocument, the read API of ValueRef )
+/// scalars convert exactly like ValueRef::as / get, strings point into the mapping,
+/// offsets are checked on access and a corrupted file throws std::runtime_error
+/////////////////////////////////////////////////////////////////////////////////////////////
+class SnapshotRef {
+    using ScalarRef = BasicValueRef<rapidjson::CrtAllocator>;
+
+public:
+    SnapshotRef(const detail::SnapshotSections& sections, const detail::SnapshotNode& node)
+        : sections_(&sections), node_(&node) {}
+
+    /// get type info
+    bool is_bool() const { return node_->type == detail::SNAPSHOT_FALSE or node_->type == detail::SNAPSHOT_TRUE; }
+    bool is_number() const { return is_integral() or is_double(); }
+    bool is_integral() const { return node_->type == detail::SNAPSHOT_INT or node_->type == detail::SNAPSHOT_UINT; }
+    bool is_double() const { return node_->type == detail::SNAPSHOT_DOUBLE; }
+    bool is_string() const { return node_->type == detail::SNAPSHOT_STRING; }
+    bool is_array() const { return node_->type == detail::SNAPSHOT_ARRAY; }
+    bool is_object() const { return node_->type == detail::SNAPSHOT_OBJECT; }
+    bool is_null() const { return node_->type == detail::SNAPSHOT_NULL; }
+
+    /// type = as<type>
+    template <typename T>
+    auto as() const -> decltype(std::declval<const ScalarRef&>().template as<T>()) {
+        typename ScalarRef::Value value;
+        rapidjson::CrtAllocator allocator;
+        return ScalarRef(scalar(value), allocator).template as<T>();
+    }
+
+    /// optional<type> = get<type>
+    template <typename T>
+    auto get() const -> decltype(std::declval<const ScalarRef&>().template get<T>()) {
+        typename ScalarRef::Value value;
+        rapidjson::CrtAllocator allocator;
+        return ScalarRef(scalar(value), allocator).template get<T>();
+    }
+
+    /// get array element ( null if out of range or not an array )
+    SnapshotRef operator[](size_t idx) const;
+
+    /// get member ( null if missing or not an object )
+    SnapshotRef operator[](const char* name) const;
+    SnapshotRef operator[](const std::string& name) const;
+
+    /// check member
+    bool has(const string_view& name) const;
+
+    /// find member ( binary search of the interned keys, then of the member index )
+    optional<SnapshotRef> find(const string_view& name) const;
+
+    /// array elements
+    SnapshotValueIterator begin() const;
+    SnapshotValueIterator end() const;
+
+    /// object members ( in document order )
+    struct Members {
+        SnapshotMemberIterator first;
+        SnapshotMemberIterator last;
+        SnapshotMemberIterator begin() const { return first; }
+        SnapshotMemberIterator end() const { return last; }
+    };
+    Members members() const;
+
+    bool empty() const;
+
+    size_t size() const;
+
+    /// string_view of a string ( empty otherwise )
+    string_view get_string() const;
+
+    std::string to_string() const;
+
+    /// SAX events of the value ( rapidjson Handler )
+    template <typename Handler>
+    bool accept(Handler& handler) const;
+
+    SnapshotRef* operator->() { return this; } // for iterator
+
+protected:
+    typename ScalarRef::Value& scalar(typename ScalarRef::Value& value) const;
+    const detail::SnapshotNode* elements() const;
+    const detail::SnapshotMember* member_nodes() const;
+    const uint32_t* member_index() const;
+    bool find_key(const string_view& name, uint32_t& offset) const;
+
+    const detail::SnapshotSections* sections_;
+    const detail::SnapshotNode*     node_;
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SnapshotMember
+/////////////////////////////////////////////////////////////////////////////////////////////
+struct SnapshotMember {
+    string_view name;
+    SnapshotRef value;
+
+    SnapshotMember* operator->() { return this; } // for iterator
+};
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SnapshotDocument ( read-only document over a snapshot written by Document::save_snapshot )
+/// the file is mapped shared read-only and nothing is parsed or copied, opening costs the same
+/// for any size and pages are read on first access, values must not be used after the document
+/// is destroyed or reloaded, and the file must not be modified while it is mapped
+/////////////////////////////////////////////////////////////////////////////////////////////
+class SnapshotDocument : public SnapshotRef {
+public:
+    SnapshotDocument();
+    SnapshotDocument(const SnapshotDocument&) = delete;
+    SnapshotDocument& operator=(const SnapshotDocument&) = delete;
+    virtual ~SnapshotDocument() = default;
+
+    bool load_from_file(const std::string& path);
+    std::string get_load_error();
+
+private:
+    bool fail(const char* error);
+
+    detail::SnapshotSections                snapshot_;
+    std::unique_ptr<detail::MappedFile>     mapped_;
+    std::string                             error_;
+};
+
+} // namespace wrapidjson
+
+#include "snapshot_impl.h"
+
+#endif // WRAPIDJSON_SNAPSHOT_H_
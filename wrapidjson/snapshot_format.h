@@ -0,0 +1,278 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2020 hadesragon@gamil.com
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy of
+// this software and associated documentation files (the "Software"), to deal in
+// the Software without restriction, including without limitation the rights to
+// use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+// the Software, and to permit persons to whom the Software is furnished to do so,
+// subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+// FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+// COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+// IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+
+#ifndef WRAPIDJSON_SNAPSHOT_FORMAT_H_
+#define WRAPIDJSON_SNAPSHOT_FORMAT_H_
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+#include <rapidjson/document.h>
+#include <rapidjson/memorystream.h>
+
+#include "lazy.h"
+
+namespace wrapidjson {
+namespace detail {
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// snapshot file layout ( native byte order, every offset is relative to its section so the
+/// file can be mapped anywhere )
+///   header | strings ( '\0' terminated ) | tree ( nodes and members ) | keys | key index
+/// keys are interned, each one is a uint32 length, the bytes and '\0', members and the index
+/// refer to the bytes, the members of an object keep the document order and are followed by
+/// their positions sorted by key offset ( uint32 each, padded to 8 bytes ) so a lookup is two
+/// binary searches
+/////////////////////////////////////////////////////////////////////////////////////////////
+enum SnapshotType : uint8_t {
+    SNAPSHOT_NULL,
+    SNAPSHOT_FALSE,
+    SNAPSHOT_TRUE,
+    SNAPSHOT_INT,       // negative, int64 bits
+    SNAPSHOT_UINT,      // uint64 bits
+    SNAPSHOT_DOUBLE,    // double bits
+    SNAPSHOT_STRING,    // payload : offset in strings, length : bytes
+    SNAPSHOT_ARRAY,     // payload : offset of length nodes in tree
+    SNAPSHOT_OBJECT,    // payload : offset of length members and their sorted positions in tree
+};
+
+struct SnapshotNode {
+    uint8_t     type;
+    uint8_t     reserved[3];
+    uint32_t    length;
+    uint64_t    payload;
+};
+
+struct SnapshotMember {
+    uint32_t        key;        // offset in keys
+    uint32_t        key_length;
+    SnapshotNode    value;
+};
+
+struct SnapshotHeader {
+    static const uint32_t VERSION = 3;   // 3 : members in document order with a sorted index
+    static const uint32_t ENDIAN_MARK = 0x01020304;
+
+    char            magic[8];   // "WRJSNAP"
+    uint32_t        version;
+    uint32_t        byte_order;
+    SnapshotNode    root;
+    uint64_t        strings_offset;
+    uint64_t        strings_size;
+    uint64_t        tree_offset;
+    uint64_t        tree_size;
+    uint64_t        keys_offset;
+    uint64_t        keys_size;
+    uint64_t        index_offset;   // key offsets sorted by key
+    uint64_t        key_count;
+};
+
+static_assert(sizeof(SnapshotNode) == 16, "unexpected snapshot node size");
+static_assert(sizeof(SnapshotMember) == 24, "unexpected snapshot member size");
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// writes a DOM as a snapshot ( strings are streamed, the tree is kept until the end )
+/////////////////////////////////////////////////////////////////////////////////////////////
+class SnapshotWriter {
+public:
+    /// lazy : strings may be LazyDocument placeholders
+    explicit SnapshotWriter(FILE* fp, bool lazy = false) : fp_(fp), lazy_(lazy) {}
+
+    template <typename Value>
+    bool write(const Value& root) {
+        SnapshotHeader header = SnapshotHeader();
+        if (fwrite(&header, sizeof(header), 1, fp_) != 1) {
+            return false;
+        }
+        node(root, header.root);
+
+        memcpy(header.magic, "WRJSNAP", 8);
+        header.version = SnapshotHeader::VERSION;
+        header.byte_order = SnapshotHeader::ENDIAN_MARK;
+        header.strings_offset = sizeof(header);
+        header.strings_size = strings_size_;
+        header.tree_offset = align(header.strings_offset + header.strings_size, 8);
+        header.tree_size = tree_.size();
+        header.keys_offset = header.tree_offset + header.tree_size;
+        header.keys_size = keys_.size();
+        header.index_offset = align(header.keys_offset + header.keys_size, 4);
+        header.key_count = key_offsets_.size();
+
+        std::vector<uint32_t> index;
+        index.reserve(key_offsets_.size());
+        for (const auto& key : key_offsets_) {
+            index.push_back(key.second);
+        }
+        std::sort(index.begin(), index.end(), [this](uint32_t a, uint32_t b) {
+            return keys_.compare(a, key_length(a), keys_, b, key_length(b)) < 0;
+        });
+
+        pad(header.tree_offset - (header.strings_offset + header.strings_size));
+        output(tree_.data(), tree_.size());
+        output(keys_.data(), keys_.size());
+        pad(header.index_offset - (header.keys_offset + header.keys_size));
+        output(index.data(), index.size() * sizeof(uint32_t));
+        if (fseek(fp_, 0, SEEK_SET) != 0) {
+            return false;
+        }
+        output(&header, sizeof(header));
+        return not failed_;
+    }
+
+private:
+    static uint64_t align(uint64_t offset, uint64_t alignment) {
+        return (offset + alignment - 1) / alignment * alignment;
+    }
+
+    void output(const void* data, size_t size) {
+        if (size > 0 and fwrite(data, 1, size, fp_) != size) {
+            failed_ = true;
+        }
+    }
+
+    void pad(uint64_t size) {
+        static const char zeros[8] = {};
+        output(zeros, static_cast<size_t>(size));
+    }
+
+    template <typename Value>
+    void node(const Value& value, SnapshotNode& out) {
+        out = SnapshotNode();
+        if (value.IsNull()) {
+            out.type = SNAPSHOT_NULL;
+        } else if (value.IsFalse()) {
+            out.type = SNAPSHOT_FALSE;
+        } else if (value.IsTrue()) {
+            out.type = SNAPSHOT_TRUE;
+        } else if (value.IsDouble()) {
+            double d = value.GetDouble();
+            out.type = SNAPSHOT_DOUBLE;
+            memcpy(&out.payload, &d, sizeof(d));
+        } else if (value.IsUint64()) {
+            out.type = SNAPSHOT_UINT;
+            out.payload = value.GetUint64();
+        } else if (value.IsInt64()) {
+            int64_t i = value.GetInt64();
+            out.type = SNAPSHOT_INT;
+            memcpy(&out.payload, &i, sizeof(i));
+        } else if (value.IsString()) {
+            const LazyNode* lazy = lazy_ ? lazy_node(value) : nullptr;
+            if (lazy != nullptr) {
+                rapidjson::Document subtree;
+                rapidjson::MemoryStream is(lazy->begin, lazy->length);
+                subtree.ParseStream(is);
+                if (subtree.HasParseError()) {
+                    failed_ = true;     // invalid lazy subtree
+                    return;
+                }
+                node(subtree, out);
+                return;
+            }
+            out.type = SNAPSHOT_STRING;
+            out.length = value.GetStringLength();
+            out.payload = string(value.GetString(), value.GetStringLength());
+        } else if (value.IsArray()) {
+            size_t at = tree_.size();
+            tree_.resize(at + value.Size() * sizeof(SnapshotNode));
+            size_t i = 0;
+            for (auto it = value.Begin(); it != value.End(); ++it, ++i) {
+                SnapshotNode child;
+                node(*it, child);
+                memcpy(&tree_[at + i * sizeof(SnapshotNode)], &child, sizeof(child));
+            }
+            out.type = SNAPSHOT_ARRAY;
+            out.length = value.Size();
+            out.payload = at;
+        } else {
+            size_t at = tree_.size();
+            size_t count = value.MemberCount();
+            size_t index_at = at + count * sizeof(SnapshotMember);
+            tree_.resize(index_at + align(count * sizeof(uint32_t), 8));
+            std::vector<SnapshotMember> members(count);
+            std::vector<uint32_t> index(count);
+            size_t i = 0;
+            for (auto it = value.MemberBegin(); it != value.MemberEnd(); ++it, ++i) {
+                members[i].key = key(it->name.GetString(), it->name.GetStringLength());
+                members[i].key_length = it->name.GetStringLength();
+                node(it->value, members[i].value);
+                index[i] = static_cast<uint32_t>(i);
+            }
+            std::stable_sort(index.begin(), index.end(), [&members](uint32_t a, uint32_t b) {
+                return members[a].key < members[b].key;     // duplicate keys keep their order, find() returns the first
+            });
+            if (count > 0) {
+                memcpy(&tree_[at], members.data(), count * sizeof(SnapshotMember));
+                memcpy(&tree_[index_at], index.data(), count * sizeof(uint32_t));
+            }
+            out.type = SNAPSHOT_OBJECT;
+            out.length = value.MemberCount();
+            out.payload = at;
+        }
+    }
+
+    uint64_t string(const char* str, size_t length) {
+        uint64_t offset = strings_size_;
+        output(str, length);
+        output("", 1);
+        strings_size_ += length + 1;
+        return offset;
+    }
+
+    uint32_t key(const char* str, size_t length) {
+        std::string name(str, length);
+        auto it = key_offsets_.find(name);
+        if (it != key_offsets_.end()) {
+            return it->second;
+        }
+        uint32_t size = static_cast<uint32_t>(length);
+        keys_.append(reinterpret_cast<const char*>(&size), sizeof(size));
+        uint32_t offset = static_cast<uint32_t>(keys_.size());
+        keys_.append(str, length);
+        keys_.push_back('\0');
+        key_offsets_.emplace(std::move(name), offset);
+        return offset;
+    }
+
+    uint32_t key_length(uint32_t offset) const {
+        uint32_t length;
+        memcpy(&length, keys_.data() + offset - sizeof(length), sizeof(length));
+        return length;
+    }
+
+    FILE*                                       fp_;
+    bool                                        lazy_;
+    uint64_t                                    strings_size_ = 0;
+    std::vector<char>                           tree_;
+    std::string                                 keys_;
+    std::unordered_map<std::string, uint32_t>   key_offsets_;
+    bool                                        failed_ = false;
+};
+
+} // namespace detail
+} // namespace wrapidjson
+
+#endif // WRAPIDJSON_SNAPSHOT_FORMAT_H_
@@ -0,0 +1,321 @@
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+namespace wrapidjson {
+namespace detail {
+
+inline void snapshot_check(bool valid) {
+    if (not valid) {
+        throw std::runtime_error("corrupted snapshot");
+    }
+}
+
+inline const SnapshotNode& snapshot_null() {
+    static const SnapshotNode node = SnapshotNode();
+    return node;
+}
+
+/// bytes [offset, offset + length) of a section followed by '\0'
+inline string_view snapshot_string(const char* section, uint64_t size, uint64_t offset, uint64_t length) {
+    snapshot_check(offset <= size and length < size - offset and section[offset + length] == '\0');
+    return string_view(section + offset, static_cast<size_t>(length));
+}
+
+inline string_view snapshot_key(const SnapshotSections& sections, uint32_t offset) {
+    uint32_t length;
+    snapshot_check(offset >= sizeof(length) and offset <= sections.keys_size);
+    memcpy(&length, sections.keys + offset - sizeof(length), sizeof(length));
+    return snapshot_string(sections.keys, sections.keys_size, offset, length);
+}
+
+} // namespace detail
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SnapshotIterator
+/////////////////////////////////////////////////////////////////////////////////////////////
+template <>
+inline SnapshotRef SnapshotValueIterator::operator*() const {
+    return SnapshotRef(*sections_, *ptr_);
+}
+
+template <>
+inline SnapshotMember SnapshotMemberIterator::operator*() const {
+    return SnapshotMember{
+        detail::snapshot_string(sections_->keys, sections_->keys_size, ptr_->key, ptr_->key_length),
+        SnapshotRef(*sections_, ptr_->value)
+    };
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SnapshotRef
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline SnapshotRef SnapshotRef::operator[](size_t idx) const {
+    if (not is_array() or idx >= node_->length) {
+        return SnapshotRef(*sections_, detail::snapshot_null());
+    }
+    return SnapshotRef(*sections_, elements()[idx]);
+}
+
+inline SnapshotRef SnapshotRef::operator[](const char* name) const {
+    auto member = find(name);
+    return member ? *member : SnapshotRef(*sections_, detail::snapshot_null());
+}
+
+inline SnapshotRef SnapshotRef::operator[](const std::string& name) const {
+    return operator[](name.c_str());
+}
+
+inline bool SnapshotRef::has(const string_view& name) const {
+    return static_cast<bool>(find(name));
+}
+
+inline optional<SnapshotRef> SnapshotRef::find(const string_view& name) const {
+    uint32_t offset = 0;
+    if (not is_object() or not find_key(name, offset)) {
+        return nonstd::nullopt;
+    }
+    const detail::SnapshotMember* members = member_nodes();
+    const uint32_t length = node_->length;
+    const uint32_t* first = member_index();
+    const uint32_t* last = first + length;
+    auto it = std::lower_bound(first, last, offset, [members, length](uint32_t position, uint32_t key) {
+        detail::snapshot_check(position < length);
+        return members[position].key < key;
+    });
+    if (it == last or members[*it].key != offset) {
+        return nonstd::nullopt;
+    }
+    return SnapshotRef(*sections_, members[*it].value);
+}
+
+inline SnapshotValueIterator SnapshotRef::begin() const {
+    return SnapshotValueIterator(*sections_, is_array() ? elements() : nullptr);
+}
+
+inline SnapshotValueIterator SnapshotRef::end() const {
+    return SnapshotValueIterator(*sections_, is_array() ? elements() + node_->length : nullptr);
+}
+
+inline SnapshotRef::Members SnapshotRef::members() const {
+    const detail::SnapshotMember* first = is_object() ? member_nodes() : nullptr;
+    const detail::SnapshotMember* last = is_object() ? first + node_->length : nullptr;
+    return Members{ SnapshotMemberIterator(*sections_, first), SnapshotMemberIterator(*sections_, last) };
+}
+
+inline bool SnapshotRef::empty() const {
+    return size() == 0 and (is_array() or is_object() or is_string());
+}
+
+inline size_t SnapshotRef::size() const {
+    if (is_array() or is_object() or is_string()) {
+        return node_->length;
+    }
+    return 0;
+}
+
+inline string_view SnapshotRef::get_string() const {
+    if (not is_string()) {
+        return string_view();
+    }
+    return detail::snapshot_string(sections_->strings, sections_->strings_size, node_->payload, node_->length);
+}
+
+inline std::string SnapshotRef::to_string() const {
+    std::string str;
+    BufferOStream<std::string> os(str);
+    rapidjson::Writer<BufferOStream<std::string>> writer(os);
+    accept(writer);
+    return str;
+}
+
+template <typename Handler>
+inline bool SnapshotRef::accept(Handler& handler) const {
+    switch (node_->type) {
+    case detail::SNAPSHOT_NULL:
+        return handler.Null();
+    case detail::SNAPSHOT_FALSE:
+        return handler.Bool(false);
+    case detail::SNAPSHOT_TRUE:
+        return handler.Bool(true);
+    case detail::SNAPSHOT_INT:
+        return handler.Int64(static_cast<int64_t>(node_->payload));
+    case detail::SNAPSHOT_UINT:
+        return handler.Uint64(node_->payload);
+    case detail::SNAPSHOT_DOUBLE: {
+        double d;
+        memcpy(&d, &node_->payload, sizeof(d));
+        return handler.Double(d);
+    }
+    case detail::SNAPSHOT_STRING: {
+        string_view str = get_string();
+        return handler.String(str.data(), static_cast<rapidjson::SizeType>(str.size()), false);
+    }
+    case detail::SNAPSHOT_ARRAY:
+        if (not handler.StartArray()) {
+            return false;
+        }
+        for (auto element : *this) {
+            if (not element.accept(handler)) {
+                return false;
+            }
+        }
+        return handler.EndArray(node_->length);
+    case detail::SNAPSHOT_OBJECT:
+        if (not handler.StartObject()) {
+            return false;
+        }
+        for (auto member : members()) {
+            if (not handler.Key(member.name.data(), static_cast<rapidjson::SizeType>(member.name.size()), false)
+                or not member.value.accept(handler)) {
+                return false;
+            }
+        }
+        return handler.EndObject(node_->length);
+    default:
+        detail::snapshot_check(false);
+        return false;
+    }
+}
+
+inline SnapshotRef::ScalarRef::Value& SnapshotRef::scalar(ScalarRef::Value& value) const {
+    switch (node_->type) {
+    case detail::SNAPSHOT_NULL:
+        value.SetNull();
+        break;
+    case detail::SNAPSHOT_FALSE:
+        value.SetBool(false);
+        break;
+    case detail::SNAPSHOT_TRUE:
+        value.SetBool(true);
+        break;
+    case detail::SNAPSHOT_INT:
+        value.SetInt64(static_cast<int64_t>(node_->payload));
+        break;
+    case detail::SNAPSHOT_UINT:
+        value.SetUint64(node_->payload);
+        break;
+    case detail::SNAPSHOT_DOUBLE: {
+        double d;
+        memcpy(&d, &node_->payload, sizeof(d));
+        value.SetDouble(d);
+        break;
+    }
+    case detail::SNAPSHOT_STRING: {
+        string_view str = get_string();   // not copied
+        value.SetString(rapidjson::StringRef(str.data(), static_cast<rapidjson::SizeType>(str.size())));
+        break;
+    }
+    case detail::SNAPSHOT_ARRAY:
+        value.SetArray();
+        break;
+    case detail::SNAPSHOT_OBJECT:
+        value.SetObject();
+        break;
+    default:
+        detail::snapshot_check(false);
+    }
+    return value;
+}
+
+inline const detail::SnapshotNode* SnapshotRef::elements() const {
+    uint64_t bytes = static_cast<uint64_t>(node_->length) * sizeof(detail::SnapshotNode);
+    detail::snapshot_check(node_->payload % 8 == 0 and node_->payload <= sections_->tree_size
+                           and bytes <= sections_->tree_size - node_->payload);
+    return reinterpret_cast<const detail::SnapshotNode*>(sections_->tree + node_->payload);
+}
+
+inline const detail::SnapshotMember* SnapshotRef::member_nodes() const {
+    uint64_t bytes = static_cast<uint64_t>(node_->length) * (sizeof(detail::SnapshotMember) + sizeof(uint32_t));
+    detail::snapshot_check(node_->payload % 8 == 0 and node_->payload <= sections_->tree_size
+                           and bytes <= sections_->tree_size - node_->payload);
+    return reinterpret_cast<const detail::SnapshotMember*>(sections_->tree + node_->payload);
+}
+
+/// positions of the members sorted by key offset, right after the members
+inline const uint32_t* SnapshotRef::member_index() const {
+    return reinterpret_cast<const uint32_t*>(member_nodes() + node_->length);
+}
+
+inline bool SnapshotRef::find_key(const string_view& name, uint32_t& offset) const {
+    const uint32_t* first = reinterpret_cast<const uint32_t*>(sections_->index);
+    const uint32_t* last = first + sections_->key_count;
+    const detail::SnapshotSections& sections = *sections_;
+    auto it = std::lower_bound(first, last, name, [&sections](uint32_t key, const string_view& name) {
+        return detail::snapshot_key(sections, key) < name;
+    });
+    if (it == last or detail::snapshot_key(sections, *it) != name) {
+        return false;
+    }
+    offset = *it;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////
+/// SnapshotDocument
+/////////////////////////////////////////////////////////////////////////////////////////////
+inline SnapshotDocument::SnapshotDocument()
+    : SnapshotRef(snapshot_, detail::snapshot_null())
+{}
+
+inline bool SnapshotDocument::load_from_file(const std::string& path) {
+    node_ = &detail::snapshot_null();
+    snapshot_ = detail::SnapshotSections();
+    mapped_.reset();
+
+    std::unique_ptr<detail::MappedFile> mapped(new detail::MappedFile());
+    if (not mapped->open(path, true)) {
+        return fail("cannot open file");
+    }
+    uint64_t size = mapped->size();
+    if (size < sizeof(detail::SnapshotHeader)) {
+        return fail("not a snapshot");
+    }
+    const auto* header = reinterpret_cast<const detail::SnapshotHeader*>(mapped->data());
+    if (memcmp(header->magic, "WRJSNAP", 8) != 0) {
+        return fail("not a snapshot");
+    }
+    if (header->byte_order != detail::SnapshotHeader::ENDIAN_MARK) {
+        return fail("snapshot of another byte order");
+    }
+    if (header->version != detail::SnapshotHeader::VERSION) {
+        return fail("unsupported snapshot version");
+    }
+    auto inside = [size](uint64_t offset, uint64_t bytes) {
+        return offset <= size and bytes <= size - offset;
+    };
+    if (not inside(header->strings_offset, header->strings_size)
+        or not inside(header->tree_offset, header->tree_size) or header->tree_offset % 8 != 0
+        or not inside(header->keys_offset, header->keys_size)
+        or header->index_offset % 4 != 0 or header->index_offset > size
+        or header->key_count > (size - header->index_offset) / sizeof(uint32_t)) {
+        return fail("truncated snapshot");
+    }
+
+    const char* data = mapped->data();
+    snapshot_.strings = data + header->strings_offset;
+    snapshot_.strings_size = header->strings_size;
+    snapshot_.tree = data + header->tree_offset;
+    snapshot_.tree_size = header->tree_size;
+    snapshot_.keys = data + header->keys_offset;
+    snapshot_.keys_size = header->keys_size;
+    snapshot_.index = data + header->index_offset;
+    snapshot_.key_count = header->key_count;
+    node_ = &header->root;
+    mapped_ = std::move(mapped);
+    error_.clear();
+    return true;
+}
+
+inline std::string SnapshotDocument::get_load_error() {
+    return error_;
+}
+
+inline bool SnapshotDocument::fail(const char* error) {
+    node_ = &detail::snapshot_null();
+    snapshot_ = detail::SnapshotSections();
+    error_ = error;
+    return false;
+}
+
+} // namespace wrapidjson
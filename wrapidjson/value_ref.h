@@ -23,13 +23,21 @@
 #define WRAPIDJSON_VALUE_REF_H
 
 #include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include <functional>
+#include <iosfwd>
+#include <type_traits>
 
 #include <rapidjson/document.h>
+#include <rapidjson/writer.h>
 
 #include "string_view.hpp"
 #include "optional.hpp"
 
 #include "type_traits.h"
+#include "compress.h"
 
 namespace wrapidjson {
 
@@ -42,24 +50,24 @@ using string_view = nonstd::string_view;
 /////////////////////////////////////////////////////////////////////////////////////////////
 template <typename IteratorType, typename ReferenceType, typename AllocatorType>
 class Iterator : public std::iterator<std::forward_iterator_tag, ReferenceType, ReferenceType, const ReferenceType*, ReferenceType> {
-    friend class ArrayRef;
-    friend class ObjectRef;
+    template <typename> friend class BasicArrayRef;
+    template <typename> friend class BasicObjectRef;
 public:
-    Iterator(IteratorType ptr, AllocatorType& allocator)
-        : ptr_(ptr), alloc_(&allocator) {}
+    Iterator(IteratorType ptr, AllocatorType& allocator, const std::shared_ptr<void>* source = nullptr)
+        : ptr_(ptr), alloc_(&allocator), source_(source) {}
     Iterator(const Iterator& rfs)
-        : ptr_(rfs.ptr_), alloc_(rfs.alloc_) {}
+        : ptr_(rfs.ptr_), alloc_(rfs.alloc_), source_(rfs.source_) {}
     ~Iterator() = default;
 
-    Iterator& operator=(const Iterator& other){ptr_ = other.ptr_; alloc_ = other.alloc_; return *this;}
+    Iterator& operator=(const Iterator& other){ptr_ = other.ptr_; alloc_ = other.alloc_; source_ = other.source_; return *this;}
 
     Iterator& operator++(){ ++ptr_; return *this; }                         // ++itr
     Iterator& operator--(){ --ptr_; return *this; }                         // --itr
     Iterator  operator++(int){ Iterator old(*this); ++ptr_; return old; }   // itr++
     Iterator  operator--(int){ Iterator old(*this); --ptr_; return old; }   // itr--
 
-    Iterator operator+(int n) const { return Iterator(ptr_+n, *alloc_); }   // itr +
-    Iterator operator-(int n) const { return Iterator(ptr_-n, *alloc_); }   // itr -
+    Iterator operator+(int n) const { return Iterator(ptr_+n, *alloc_, source_); }  // itr +
+    Iterator operator-(int n) const { return Iterator(ptr_-n, *alloc_, source_); }  // itr -
 
     Iterator& operator+=(int n) { ptr_+=n; return *this; }                  // itr +=
     Iterator& operator-=(int n) { ptr_-=n; return *this; }                  // itr -=
@@ -72,51 +80,104 @@ public:
     bool operator> (const Iterator& rfs) const { return ptr_ > rfs.ptr_; }
     int  operator- (const Iterator& rfs) const { return ptr_ - rfs.ptr_; }
 
-    ReferenceType operator*() const { return ReferenceType(*ptr_, *alloc_); }
-    ReferenceType operator->() const { return ReferenceType(*ptr_, *alloc_); }
-    ReferenceType operator[](size_t n) const { return ReferenceType(ptr_[n], *alloc_); }
+    ReferenceType operator*() const { return ReferenceType(*ptr_, *alloc_, source_); }
+    ReferenceType operator->() const { return ReferenceType(*ptr_, *alloc_, source_); }
+    ReferenceType operator[](size_t n) const { return ReferenceType(ptr_[n], *alloc_, source_); }
 
 private:
-    IteratorType    ptr_;
-    AllocatorType*  alloc_;
+    IteratorType                    ptr_;
+    AllocatorType*                  alloc_;
+    const std::shared_ptr<void>*    source_;
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////
-/// Predefine class
+/// Predefine class ( Allocator : rapidjson Allocator of the values, MemoryPoolAllocator<> by default )
 /////////////////////////////////////////////////////////////////////////////////////////////
-class ValueRef;
-class ArrayRef;
-class ObjectRef;
-class Document;
-struct MemberRef;
+template <typename Allocator = rapidjson::MemoryPoolAllocator<>> class BasicValueRef;
+template <typename Allocator = rapidjson::MemoryPoolAllocator<>> class BasicArrayRef;
+template <typename Allocator = rapidjson::MemoryPoolAllocator<>> class BasicObjectRef;
+template <typename Allocator = rapidjson::MemoryPoolAllocator<>> struct BasicMemberRef;
+template <unsigned ParseFlags = rapidjson::kParseDefaultFlags,
+          unsigned WriteFlags = rapidjson::kWriteDefaultFlags,
+          typename Allocator = rapidjson::MemoryPoolAllocator<>>
+class BasicDocument;
+class LazyDocument;
+
+using ValueRef = BasicValueRef<>;
+using ArrayRef = BasicArrayRef<>;
+using ObjectRef = BasicObjectRef<>;
+using MemberRef = BasicMemberRef<>;
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// Iterator for ValueRef, ArrayRef, ObjectRef
 /////////////////////////////////////////////////////////////////////////////////////////////
-using ValueIterator = Iterator<rapidjson::Value::ValueIterator, ValueRef, rapidjson::Document::AllocatorType>;
-using MemberIterator = Iterator<rapidjson::Value::MemberIterator, MemberRef, rapidjson::Document::AllocatorType>;
+template <typename Allocator>
+using BasicValueIterator = Iterator<typename rapidjson::GenericValue<rapidjson::UTF8<>, Allocator>::ValueIterator, BasicValueRef<Allocator>, Allocator>;
+template <typename Allocator>
+using BasicMemberIterator = Iterator<typename rapidjson::GenericValue<rapidjson::UTF8<>, Allocator>::MemberIterator, BasicMemberRef<Allocator>, Allocator>;
+
+using ValueIterator = BasicValueIterator<rapidjson::MemoryPoolAllocator<>>;
+using MemberIterator = BasicMemberIterator<rapidjson::MemoryPoolAllocator<>>;
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// ValueRef for rapidjson::value
+/// a LazyDocument placeholder is parsed one level when a ValueRef is made over it
+/// ( operator[], find, iteration ), std::runtime_error if its text is invalid
 /////////////////////////////////////////////////////////////////////////////////////////////
-class ValueRef {
-    friend class ArrayRef;
-    friend class ObjectRef;
+template <typename Allocator>
+class BasicValueRef {
+    template <typename> friend class BasicArrayRef;
+    template <typename> friend class BasicObjectRef;
+    friend class LazyDocument;
 
 public:
+    using Value = rapidjson::GenericValue<rapidjson::UTF8<>, Allocator>;
+    using ValueRef = BasicValueRef<Allocator>;
+    using ArrayRef = BasicArrayRef<Allocator>;
+    using ObjectRef = BasicObjectRef<Allocator>;
+    using MemberRef = BasicMemberRef<Allocator>;
+    using ValueIterator = BasicValueIterator<Allocator>;
+    using MemberIterator = BasicMemberIterator<Allocator>;
+
+    /// value marked to be moved by take()
+    class Taken {
+        friend class BasicValueRef;
+        template <unsigned, unsigned, typename> friend class BasicDocument;
+        Taken(Value& value, Allocator& allocator, const std::shared_ptr<void>* source)
+            : value_(value), alloc_(allocator), source_(source) {}
+        Value&                          value_;
+        Allocator&                      alloc_;
+        const std::shared_ptr<void>*    source_;
+    };
+
     /// constructors:
-    ValueRef(rapidjson::Value&, rapidjson::Document::AllocatorType&);
-    ValueRef(const ValueRef&);
-    ValueRef(const ArrayRef&);
-    ValueRef(const ObjectRef&);
-    ValueRef(const Document&);
+    /// source : in-situ source of the document the value is in ( see take() )
+    BasicValueRef(Value&, Allocator&, const std::shared_ptr<void>* source = nullptr);
+    BasicValueRef(const ValueRef&);
+    BasicValueRef(const ArrayRef&);
+    BasicValueRef(const ObjectRef&);
+    template <unsigned ParseFlags, unsigned WriteFlags>
+    BasicValueRef(const BasicDocument<ParseFlags, WriteFlags, Allocator>&);
 
     /// destructor
-    virtual ~ValueRef() = default;
+    virtual ~BasicValueRef() = default;
 
     /// copy assignment
     ValueRef& operator=(const ValueRef&);
-    ValueRef& operator=(const Document&);
+    template <unsigned ParseFlags, unsigned WriteFlags>
+    ValueRef& operator=(const BasicDocument<ParseFlags, WriteFlags, Allocator>&);
+
+    /// move assignment ( see take() )
+    ValueRef& operator=(Taken taken);
+    template <unsigned ParseFlags, unsigned WriteFlags>
+    ValueRef& operator=(BasicDocument<ParseFlags, WriteFlags, Allocator>&&);
+
+    /// mark the value to be moved : dst = src.take(), array.push_back(src.take()),
+    /// object.insert(name, src.take()) steal it in O(1) when both sides use the same allocator
+    /// ( or CrtAllocator ) and copy it otherwise, the source is null afterwards and the
+    /// destination must not be inside it. Values of another document that keeps an in-situ or
+    /// mmap source are copied too, their strings point into it
+    Taken take() { return Taken(value_, alloc_, source_); }
 
     template<typename T>
     ValueRef& operator=(T value) {
@@ -170,6 +231,15 @@ public:
     /// assign from Object reference
     ValueRef& operator=(const ObjectRef& object);
 
+    /// parse JSON straight into the value with the allocator of its document
+    /// ( no temporary document and no deep copy, the value is unchanged on error )
+    template <unsigned ParseFlags = rapidjson::kParseDefaultFlags>
+    bool parse(const string_view& json);
+
+    /// same from a rapidjson input stream ( IStream, SegmentStream ... )
+    template <unsigned ParseFlags = rapidjson::kParseDefaultFlags, typename InputStream>
+    bool parse_stream(InputStream& is);
+
     /// assign from all continaer ( array, map )
     template<template <typename...> class Container, typename ...Args>
     ValueRef& operator=(const Container<Args...>& container) {
@@ -212,6 +282,7 @@ public:
 
     /// set to Array
     void push_back(const ValueRef& value);
+    void push_back(Taken value);
 
     /// get array
     ValueRef operator[](size_t idx) const;
@@ -301,11 +372,17 @@ public:
     ArrayRef get_array() const;
     ObjectRef get_object() const;
 
-    rapidjson::Value& get_rvalue() const;
+    Value& get_rvalue() const;
 
     ValueRef* operator->() { return this; } // for iterator
 
-    std::string to_string();
+    /// serialize the subtree straight from the value ( no copy into a temporary document )
+    std::string to_string() const;
+    /// out is cleared first ( capacity reused )
+    bool to_string(std::string& out, bool pretty = false) const;
+    bool save_to_stream(std::ostream& os, bool pretty = false) const;
+    /// gzip and zstd as Document::save_to_file
+    bool save_to_file(const std::string& path, bool pretty = false, Compression compression = Compression::none) const;
 
     bool empty() const;
 
@@ -365,22 +442,40 @@ public:
     void set_container(const Container<std::string, unsigned long long, Args...>& map, bool str_copy = true);
 
 protected:
-    rapidjson::Value&                   value_;
-    rapidjson::Document::AllocatorType& alloc_;
+    /// values allocated by one can be owned by the other
+    static bool same_allocator(const Allocator& a, const Allocator& b) {
+        return &a == &b or std::is_same<Allocator, rapidjson::CrtAllocator>::value;   // CrtAllocator has no state
+    }
+
+    template <typename Sink>
+    bool save_to_sink(Sink& sink, bool pretty) const;
+
+    Value&                          value_;
+    Allocator&                      alloc_;
+    const std::shared_ptr<void>*    source_;    // buffer_ of the document, null outside one
 };
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// ArrayRef ( Reference Value for array )
 /////////////////////////////////////////////////////////////////////////////////////////////
-class ArrayRef {
-    friend class ValueRef;
+template <typename Allocator>
+class BasicArrayRef {
+    template <typename> friend class BasicValueRef;
 
 public:
-    ArrayRef(const ArrayRef&);
-    ArrayRef(const ValueRef& value);
+    using Value = rapidjson::GenericValue<rapidjson::UTF8<>, Allocator>;
+    using ValueRef = BasicValueRef<Allocator>;
+    using ArrayRef = BasicArrayRef<Allocator>;
+    using ObjectRef = BasicObjectRef<Allocator>;
+    using MemberRef = BasicMemberRef<Allocator>;
+    using ValueIterator = BasicValueIterator<Allocator>;
+    using MemberIterator = BasicMemberIterator<Allocator>;
+
+    BasicArrayRef(const ArrayRef&);
+    BasicArrayRef(const ValueRef& value);
     ArrayRef& operator=(const ArrayRef& other) = delete;
 
-    ~ArrayRef() = default;
+    ~BasicArrayRef() = default;
 
     template<typename T, template <typename...> class Container, typename...Args,
         detail::enable_if_sequence_t<T, Container, Args...>* = nullptr
@@ -418,6 +513,8 @@ public:
 
     template<typename T>
     void push_back(T&& value);
+    /// copy or move is not implied by an rvalue ValueRef : push_back(src) or push_back(src.take())
+    void push_back(ValueRef&& value) = delete;
     ValueRef push_back();
     void pop_back();
     ValueIterator erase(const ValueIterator& pos);
@@ -432,14 +529,23 @@ protected:
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// ObjectRef ( Reference rapidjson::value for Object )
 /////////////////////////////////////////////////////////////////////////////////////////////
-class ObjectRef {
-    friend class ValueRef;
+template <typename Allocator>
+class BasicObjectRef {
+    template <typename> friend class BasicValueRef;
 
 public:
-    ObjectRef(const ValueRef&);
-    ObjectRef(const ObjectRef&);
+    using Value = rapidjson::GenericValue<rapidjson::UTF8<>, Allocator>;
+    using ValueRef = BasicValueRef<Allocator>;
+    using ArrayRef = BasicArrayRef<Allocator>;
+    using ObjectRef = BasicObjectRef<Allocator>;
+    using MemberRef = BasicMemberRef<Allocator>;
+    using ValueIterator = BasicValueIterator<Allocator>;
+    using MemberIterator = BasicMemberIterator<Allocator>;
 
-    ~ObjectRef() = default;
+    BasicObjectRef(const ValueRef&);
+    BasicObjectRef(const ObjectRef&);
+
+    ~BasicObjectRef() = default;
 
     ObjectRef& operator=(const ObjectRef& other) = delete;
 
@@ -505,6 +611,11 @@ public:
     template<typename T>
     void insert(const string_view& name, T&& value);
 
+    /// copy or move is not implied by an rvalue ValueRef : insert(name, src) or insert(name, src.take())
+    void insert(const char* name, ValueRef&& value) = delete;
+    void insert(const std::string& name, ValueRef&& value) = delete;
+    void insert(const string_view& name, ValueRef&& value) = delete;
+
     ValueRef insert(const char* name);
     ValueRef insert(const std::string& name);
     ValueRef insert(const string_view& name);
@@ -1,68 +1,187 @@
 #include "format.h"
 #include "parse.h"
+#include "lazy.h"
+
+#include <rapidjson/memorystream.h>
 
 namespace wrapidjson {
+namespace detail {
+
+/// deep copy into an empty dst, const strings ( in-situ, string_view ) are copied as well so the
+/// copy does not point into the source buffer ( CopyFrom only copies their pointer ), LazyDocument
+/// subtrees are parsed in full and throw std::runtime_error if invalid
+template <typename Value, typename SourceValue, typename Allocator>
+inline void copy_value(Value& dst, const SourceValue& src, Allocator& alloc) {
+    const LazyNode* node = nullptr;
+    switch (src.GetType()) {
+    case rapidjson::kStringType:
+        node = lazy_node(src);
+        if (node == nullptr) {
+            dst.SetString(src.GetString(), src.GetStringLength(), alloc);
+        } else if (not parse_lazy(dst, *node, alloc)) {
+            throw std::runtime_error("invalid JSON in lazy value");
+        }
+        break;
+    case rapidjson::kArrayType:
+        dst.SetArray();
+        dst.Reserve(src.Size(), alloc);
+        for (auto it = src.Begin(); it != src.End(); ++it) {
+            Value element;
+            copy_value(element, *it, alloc);
+            dst.PushBack(element, alloc);
+        }
+        break;
+    case rapidjson::kObjectType:
+        dst.SetObject();
+        for (auto it = src.MemberBegin(); it != src.MemberEnd(); ++it) {
+            Value name(it->name.GetString(), it->name.GetStringLength(), alloc);
+            Value value;
+            copy_value(value, it->value, alloc);
+            dst.AddMember(name, value, alloc);
+        }
+        break;
+    default:
+        dst.CopyFrom(src, alloc);   // null, bool, number
+    }
+}
+
+/// dst = deep copy of src ( built aside, src may be inside dst )
+template <typename Value, typename SourceValue, typename Allocator>
+inline void assign_copy(Value& dst, const SourceValue& src, Allocator& alloc) {
+    Value copy;
+    copy_value(copy, src, alloc);
+    dst.Swap(copy);
+}
+
+} // namespace detail
 
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// ValueRef for rapidjson::value
 /////////////////////////////////////////////////////////////////////////////////////////////
-inline ValueRef::ValueRef(rapidjson::Value& value, rapidjson::Document::AllocatorType& alloc)
-    : value_(value), alloc_(alloc)
-{}
-inline ValueRef::ValueRef(const ValueRef& rfs)
-    : value_(rfs.value_), alloc_(rfs.alloc_)
+template <typename Allocator>
+inline BasicValueRef<Allocator>::BasicValueRef(Value& value, Allocator& alloc, const std::shared_ptr<void>* source)
+    : value_(value), alloc_(alloc), source_(source)
+{
+    if (not detail::materialize(value_, alloc_)) {
+        throw std::runtime_error("invalid JSON in lazy value");
+    }
+}
+template <typename Allocator>
+inline BasicValueRef<Allocator>::BasicValueRef(const ValueRef& rfs)
+    : value_(rfs.value_), alloc_(rfs.alloc_), source_(rfs.source_)
 {}
-inline ValueRef::ValueRef(const ArrayRef& array)
-    : value_(array.get_value_ref().value_), alloc_(array.get_value_ref().alloc_)
+template <typename Allocator>
+inline BasicValueRef<Allocator>::BasicValueRef(const ArrayRef& array)
+    : value_(array.get_value_ref().value_), alloc_(array.get_value_ref().alloc_), source_(array.get_value_ref().source_)
 {}
 
-inline ValueRef::ValueRef(const ObjectRef& obj)
-    : value_(obj.get_value_ref().value_), alloc_(obj.get_value_ref().alloc_)
+template <typename Allocator>
+inline BasicValueRef<Allocator>::BasicValueRef(const ObjectRef& obj)
+    : value_(obj.get_value_ref().value_), alloc_(obj.get_value_ref().alloc_), source_(obj.get_value_ref().source_)
 {}
 
 /// copy assignment
-inline ValueRef& ValueRef::operator=(const ValueRef& other) {
+template <typename Allocator>
+inline BasicValueRef<Allocator>& BasicValueRef<Allocator>::operator=(const ValueRef& other) {
     if (this != &other) {
-        value_.CopyFrom(other.value_, alloc_); // copy value explicitly
+        detail::assign_copy(value_, other.value_, alloc_);  // copy value explicitly
     }
     return *this;
 }
 
+/// move assignment
+template <typename Allocator>
+inline BasicValueRef<Allocator>& BasicValueRef<Allocator>::operator=(Taken taken) {
+    if (&value_ == &taken.value_) {
+        return *this;
+    }
+    // built aside before value_ is released, the source may be inside it
+    // strings of another document may point into the in-situ source it keeps
+    bool borrowed = taken.source_ != nullptr and taken.source_ != source_ and *taken.source_ != nullptr;
+    Value tmp;
+    if (same_allocator(alloc_, taken.alloc_) and not borrowed) {
+        tmp.Swap(taken.value_);
+    } else {
+        detail::copy_value(tmp, taken.value_, alloc_);
+        taken.value_.SetNull();
+    }
+    value_.Swap(tmp);
+    return *this;
+}
+
 /// catches std::string (makes a copy):
-inline ValueRef& ValueRef::operator=(const std::string& s) {
+template <typename Allocator>
+inline BasicValueRef<Allocator>& BasicValueRef<Allocator>::operator=(const std::string& s) {
     value_.SetString(s.data(), s.length(), alloc_); // make copy via allocator!
     return *this;
 }
 
-inline ValueRef& ValueRef::operator=(const char* s) {
+template <typename Allocator>
+inline BasicValueRef<Allocator>& BasicValueRef<Allocator>::operator=(const char* s) {
     value_.SetString(s, alloc_); // make copy via allocator!
     return *this;
 }
 
-inline ValueRef& ValueRef::operator=(const string_view& s) {
+template <typename Allocator>
+inline BasicValueRef<Allocator>& BasicValueRef<Allocator>::operator=(const string_view& s) {
     value_.SetString(s.data(), s.length());
     return *this;
 }
 
 /// assign from Array reference
-inline ValueRef& ValueRef::operator=(const ArrayRef& array)
+template <typename Allocator>
+inline BasicValueRef<Allocator>& BasicValueRef<Allocator>::operator=(const ArrayRef& array)
 {
     return operator=(array.valueRef_);
 }
 
-inline ValueRef& ValueRef::operator=(const ObjectRef& object)
+template <typename Allocator>
+inline BasicValueRef<Allocator>& BasicValueRef<Allocator>::operator=(const ObjectRef& object)
 {
     return operator=(object.valueRef_);
 }
 
+/// parse into the value
+template <typename Allocator>
+template <unsigned ParseFlags>
+inline bool BasicValueRef<Allocator>::parse(const string_view& json) {
+    rapidjson::MemoryStream is(json.data(), json.size());
+    return parse_stream<ParseFlags>(is);
+}
+
+template <typename Allocator>
+template <unsigned ParseFlags, typename InputStream>
+inline bool BasicValueRef<Allocator>::parse_stream(InputStream& is) {
+    static_assert((ParseFlags & rapidjson::kParseInsituFlag) == 0, "the source is not owned by the value");
+    rapidjson::GenericDocument<rapidjson::UTF8<>, Allocator> document(&alloc_);    // borrows the allocator
+    document.template ParseStream<ParseFlags>(is);
+    if (document.HasParseError()) {
+        return false;
+    }
+    value_.Swap(document);  // the previous value is released with the temporary root
+    return true;
+}
+
 /// set to empty Array
-inline ArrayRef ValueRef::set_array() {
+template <typename Allocator>
+inline BasicArrayRef<Allocator> BasicValueRef<Allocator>::set_array() {
     value_.SetArray();
     return ArrayRef(*this);
 }
 
 /// set to empty Array
-inline void ValueRef::push_back(const ValueRef& value) {
+template <typename Allocator>
+inline void BasicValueRef<Allocator>::push_back(const ValueRef& value) {
+    if ( value_.IsNull()) {
+        value_.SetArray();
+    } else if ( not value_.IsArray() ) {
+        throw std::runtime_error("ValueRef::push_back allow only ArrayType");
+    }
+    ArrayRef(*this).push_back(value);
+}
+
+template <typename Allocator>
+inline void BasicValueRef<Allocator>::push_back(Taken value) {
     if ( value_.IsNull()) {
         value_.SetArray();
     } else if ( not value_.IsArray() ) {
@@ -72,7 +191,8 @@ inline void ValueRef::push_back(const ValueRef& value) {
 }
 
 /// set to empty Array
-inline ValueRef ValueRef::operator[](size_t idx) const {
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicValueRef<Allocator>::operator[](size_t idx) const {
     if ( not value_.IsArray() ) {
         throw std::runtime_error(detail::format("ValueRef[%u] allow only ArrayType", idx));
     } else if (idx >= value_.Size() ) {
@@ -81,13 +201,15 @@ inline ValueRef ValueRef::operator[](size_t idx) const {
     return ArrayRef(*this)[idx];
 }
 
-inline ObjectRef ValueRef::set_object() {
+template <typename Allocator>
+inline BasicObjectRef<Allocator> BasicValueRef<Allocator>::set_object() {
     value_.SetObject();
     return ObjectRef(*this);
 }
 
 /// set to Object
-inline ValueRef ValueRef::operator[](const char* name) const {
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicValueRef<Allocator>::operator[](const char* name) const {
     if ( value_.IsNull() ) {
         value_.SetObject();
     } else if (not value_.IsObject()) {
@@ -96,18 +218,21 @@ inline ValueRef ValueRef::operator[](const char* name) const {
     return ObjectRef(*this)[name];
 }
 /// set to Object
-inline ValueRef ValueRef::operator[](const std::string& name) const {
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicValueRef<Allocator>::operator[](const std::string& name) const {
     return this->operator[](name.c_str());
 }
 /// check member
-inline bool ValueRef::has(const std::string& name) const {
+template <typename Allocator>
+inline bool BasicValueRef<Allocator>::has(const std::string& name) const {
     if (value_.IsObject()) {
         return ObjectRef(*this).has(name);
     }
     return false;
 }
 /// find member
-inline optional<ValueRef> ValueRef::find(const std::string& name) const {
+template <typename Allocator>
+inline optional<BasicValueRef<Allocator>> BasicValueRef<Allocator>::find(const std::string& name) const {
     optional<ValueRef> ret;
     if ( value_.IsObject() ) {
         ret = ObjectRef(*this).find(name);
@@ -115,20 +240,25 @@ inline optional<ValueRef> ValueRef::find(const std::string& name) const {
     return ret;
 }
 
-inline rapidjson::Value& ValueRef::get_rvalue() const {
+template <typename Allocator>
+inline typename BasicValueRef<Allocator>::Value& BasicValueRef<Allocator>::get_rvalue() const {
     return value_;
 }
-inline ValueRef ValueRef::get_ref() const {
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicValueRef<Allocator>::get_ref() const {
     return *this;
 }
-inline ArrayRef ValueRef::get_array() const {
+template <typename Allocator>
+inline BasicArrayRef<Allocator> BasicValueRef<Allocator>::get_array() const {
     return ArrayRef(*this);
 }
-inline ObjectRef ValueRef::get_object() const {
+template <typename Allocator>
+inline BasicObjectRef<Allocator> BasicValueRef<Allocator>::get_object() const {
     return ObjectRef(*this);
 }
 
-inline bool ValueRef::empty() const {
+template <typename Allocator>
+inline bool BasicValueRef<Allocator>::empty() const {
     if ( value_.IsObject() ) {
         return value_.ObjectEmpty();
     } else if ( value_.IsArray() ) {
@@ -139,7 +269,8 @@ inline bool ValueRef::empty() const {
     return false;
 }
 
-inline size_t ValueRef::size() const {
+template <typename Allocator>
+inline size_t BasicValueRef<Allocator>::size() const {
     if ( value_.IsObject() ) {
         return value_.MemberCount();
     } else if ( value_.IsArray() ) {
@@ -154,8 +285,9 @@ inline size_t ValueRef::size() const {
 /// ValueRef::as tempalte impl
 /// type = as<type> 인터페이스
 /////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Allocator>
 template<typename T, detail::enable_if_num_t<T>*>
-inline T ValueRef::as() const {
+inline T BasicValueRef<Allocator>::as() const {
     if (value_.IsNumber()) {
         if (value_.IsInt()) {
             return static_cast<T>(value_.GetInt());
@@ -176,8 +308,9 @@ inline T ValueRef::as() const {
     return 0;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_char_t<T>*>
-inline char ValueRef::as() const {
+inline char BasicValueRef<Allocator>::as() const {
     if (value_.IsNumber()) {
         if (value_.IsInt()) {
             return static_cast<char>(value_.GetInt());
@@ -197,16 +330,18 @@ inline char ValueRef::as() const {
 }
 
 
+template <typename Allocator>
 template<typename T, detail::enable_if_cptr_t<T>*>
-inline const char* ValueRef::as() const {
+inline const char* BasicValueRef<Allocator>::as() const {
     if (value_.IsString()) {
         return value_.GetString();
     }
     return nullptr;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_str_t<T>*>
-inline std::string ValueRef::as() const {
+inline std::string BasicValueRef<Allocator>::as() const {
     if (value_.IsNumber()) {
         if (value_.IsInt()) {
             return std::to_string(value_.GetInt());
@@ -231,8 +366,9 @@ inline std::string ValueRef::as() const {
 /// ValueRef::get tempalte impl
 /// optional<type> = get<type> 인터페이스
 /////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Allocator>
 template<typename T, detail::enable_if_bool_t<T>*>
-inline optional<bool> ValueRef::get() const {
+inline optional<bool> BasicValueRef<Allocator>::get() const {
     optional<bool> res;
     if ( value_.IsBool() ) {
         res = value_.GetBool();
@@ -240,8 +376,9 @@ inline optional<bool> ValueRef::get() const {
     return res;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_char_t<T>*>
-inline optional<char> ValueRef::get() const {
+inline optional<char> BasicValueRef<Allocator>::get() const {
     optional<char> res;
     if (value_.IsString() && value_.GetStringLength() == 1) {
         res = value_.GetString()[0];
@@ -249,8 +386,9 @@ inline optional<char> ValueRef::get() const {
     return res;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_int64_t<T>*>
-inline optional<T> ValueRef::get() const {
+inline optional<T> BasicValueRef<Allocator>::get() const {
     optional<T> res;
     if ( value_.IsInt64() ) {
         res = static_cast<T>(value_.GetInt64());
@@ -258,8 +396,9 @@ inline optional<T> ValueRef::get() const {
     return res;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_int_t<T>*>
-inline optional<T> ValueRef::get() const {
+inline optional<T> BasicValueRef<Allocator>::get() const {
     optional<T> res;
     if ( value_.IsInt() and
             value_.GetInt() >= std::numeric_limits<T>::min() and
@@ -269,8 +408,9 @@ inline optional<T> ValueRef::get() const {
     return res;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_uint64_t<T>*>
-inline optional<T> ValueRef::get() const {
+inline optional<T> BasicValueRef<Allocator>::get() const {
     optional<T> res;
     if ( value_.IsUint64() ) {
         res = static_cast<T>(value_.GetUint64());
@@ -278,8 +418,9 @@ inline optional<T> ValueRef::get() const {
     return res;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_uint_t<T>*>
-inline optional<T> ValueRef::get() const {
+inline optional<T> BasicValueRef<Allocator>::get() const {
     optional<T> res;
     if ( value_.IsUint() and
             value_.GetUint() >= std::numeric_limits<T>::min() and
@@ -289,8 +430,9 @@ inline optional<T> ValueRef::get() const {
     return res;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_float_t<T>*>
-inline optional<T> ValueRef::get() const {
+inline optional<T> BasicValueRef<Allocator>::get() const {
     optional<T> res;
     if (value_.IsNumber()) {
         res = static_cast<T>(value_.GetDouble());
@@ -298,8 +440,9 @@ inline optional<T> ValueRef::get() const {
     return res;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_cptr_t<T>*>
-inline optional<const char*> ValueRef::get() const {
+inline optional<const char*> BasicValueRef<Allocator>::get() const {
     optional<const char*> res;
     if (value_.IsString()) {
         res = value_.GetString();
@@ -307,8 +450,9 @@ inline optional<const char*> ValueRef::get() const {
     return res;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_str_t<T>*>
-inline optional<std::string> ValueRef::get() const {
+inline optional<std::string> BasicValueRef<Allocator>::get() const {
     optional<std::string> res;
     if (value_.IsString()) {
         res = std::string(value_.GetString(), value_.GetStringLength());
@@ -321,65 +465,69 @@ inline optional<std::string> ValueRef::get() const {
 /////////////////////////////////////////////////////////////////////////////////////////////
 
 /// set Container ( Container<Number> )
+template <typename Allocator>
 template<typename T, template <typename...> class Container, typename...Args, 
     detail::enable_if_sequence_t<T, Container, Args...>*
 >
-inline void ValueRef::set_container(const Container<T, Args...>& array, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<T, Args...>& array, bool str_copy)
 {
     (void)str_copy;
     value_.SetArray();
     value_.Reserve(array.size(), alloc_);
     for (auto& k : array) {
-        value_.PushBack(rapidjson::Value(k), alloc_);
+        value_.PushBack(Value(k), alloc_);
     }
 }
 
 
 /// set Container ( Continaer<String> )
+template <typename Allocator>
 template<template <typename...> class Container, typename...Args,
     detail::enable_if_sequence_t<std::string, Container, Args...>*
 >
-inline void ValueRef::set_container(const Container<std::string, Args...>& array, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<std::string, Args...>& array, bool str_copy)
 {
     value_.SetArray();
     value_.Reserve(array.size(), alloc_);
     for (auto& k : array) {
         if ( str_copy ) {
-            value_.PushBack(rapidjson::Value(k.data(), k.length(), alloc_), alloc_);    // string copy
+            value_.PushBack(Value(k.data(), k.length(), alloc_), alloc_);    // string copy
         } else {
-            value_.PushBack(rapidjson::Value(k.data(), k.length()), alloc_);            // string not copy
+            value_.PushBack(Value(k.data(), k.length()), alloc_);            // string not copy
         }
     }
 }
 
 /// assing from map<string, T>
+template <typename Allocator>
 template<typename T, template <typename...> class Container, typename...Args,
     detail::enable_if_strmap_t<T, Container, Args...>*
 >
-inline void ValueRef::set_container(const Container<std::string, T, Args...>& map, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<std::string, T, Args...>& map, bool str_copy)
 {
     value_.SetObject();
     for (auto& k : map){
-        rapidjson::Value name;
+        Value name;
         if ( str_copy ) {
             name.SetString(k.first.data(), k.first.length(), alloc_);
         } else {
             name.SetString(k.first.data(), k.first.length());
         }
-        rapidjson::Value value(k.second);
+        Value value(k.second);
         value_.AddMember(name.Move(), value.Move(), alloc_);
     }
 }
 
 /// assign from map<string, string>
+template <typename Allocator>
 template<template <typename...> class Container, typename ...Args,
     detail::enable_if_strmap_t<std::string, Container, Args...>*
 >
-inline void ValueRef::set_container(const Container<std::string, std::string>& map, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<std::string, std::string>& map, bool str_copy)
 {
     value_.SetObject();
     for (auto& k : map){
-        rapidjson::Value name, value;
+        Value name, value;
         if ( str_copy ) {
             name.SetString(k.first.data(), k.first.length(), alloc_);
             value.SetString(k.second.data(), k.second.length(), alloc_);
@@ -395,59 +543,63 @@ inline void ValueRef::set_container(const Container<std::string, std::string>& m
 // long != rapidjson::SizeType(int64_t)
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// set Container ( Container<long> )
+template <typename Allocator>
 template<template <typename...> class Container, typename...Args, detail::enable_if_l_sequence_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<long, Args...>& array, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<long, Args...>& array, bool str_copy)
 {
     (void)str_copy;
     value_.SetArray();
     value_.Reserve(array.size(), alloc_);
     for (auto& k : array) {
-        value_.PushBack(rapidjson::Value(static_cast<int64_t>(k)), alloc_);
+        value_.PushBack(Value(static_cast<int64_t>(k)), alloc_);
     }
 }
 
 /// set Container ( Container<unsigned long> )
+template <typename Allocator>
 template<template <typename...> class Container, typename...Args, detail::enable_if_ul_sequence_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<unsigned long, Args...>& array, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<unsigned long, Args...>& array, bool str_copy)
 {
     (void)str_copy;
     value_.SetArray();
     value_.Reserve(array.size(), alloc_);
     for (auto& k : array) {
-        value_.PushBack(rapidjson::Value(static_cast<uint64_t>(k)), alloc_);
+        value_.PushBack(Value(static_cast<uint64_t>(k)), alloc_);
     }
 }
 
 /// assign from map<string, long>
+template <typename Allocator>
 template<template <typename...> class Container, typename...Args, detail::enable_if_str_l_map_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<std::string, long, Args...>& map, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<std::string, long, Args...>& map, bool str_copy)
 {
     value_.SetObject();
     for (auto& k : map){
-        rapidjson::Value name;
+        Value name;
         if ( str_copy ) {
             name.SetString(k.first.data(), k.first.length(), alloc_);
         } else {
             name.SetString(k.first.data(), k.first.length());
         }
-        rapidjson::Value value(static_cast<int64_t>(k.second));
+        Value value(static_cast<int64_t>(k.second));
         value_.AddMember(name.Move(), value.Move(), alloc_);
     }
 }
 
 /// assign from map<string, unsigned long>
+template <typename Allocator>
 template<template <typename...> class Container, typename...Args, detail::enable_if_str_ul_map_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<std::string, unsigned long, Args...>& map, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<std::string, unsigned long, Args...>& map, bool str_copy)
 {
     value_.SetObject();
     for (auto& k : map){
-        rapidjson::Value name;
+        Value name;
         if ( str_copy ) {
             name.SetString(k.first.data(), k.first.length(), alloc_);
         } else {
             name.SetString(k.first.data(), k.first.length());
         }
-        rapidjson::Value value(static_cast<uint64_t>(k.second));
+        Value value(static_cast<uint64_t>(k.second));
         value_.AddMember(name.Move(), value.Move(), alloc_);
     }
 }
@@ -456,59 +608,63 @@ inline void ValueRef::set_container(const Container<std::string, unsigned long,
 // long long != rapidjson::SizeType(int64_t)
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 /// set Container ( Container<long long> )
+template <typename Allocator>
 template<template <typename...> class Container, typename...Args, detail::enable_if_ll_sequence_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<long long, Args...>& array, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<long long, Args...>& array, bool str_copy)
 {
     (void)str_copy;
     value_.SetArray();
     value_.Reserve(array.size(), alloc_);
     for (auto& k : array) {
-        value_.PushBack(rapidjson::Value(static_cast<int64_t>(k)), alloc_);
+        value_.PushBack(Value(static_cast<int64_t>(k)), alloc_);
     }
 }
 
 /// set Container ( Container<unsigned long long> )
+template <typename Allocator>
 template<template <typename...> class Container, typename...Args, detail::enable_if_ull_sequence_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<unsigned long long, Args...>& array, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<unsigned long long, Args...>& array, bool str_copy)
 {
     (void)str_copy;
     value_.SetArray();
     value_.Reserve(array.size(), alloc_);
     for (auto& k : array) {
-        value_.PushBack(rapidjson::Value(static_cast<uint64_t>(k)), alloc_);
+        value_.PushBack(Value(static_cast<uint64_t>(k)), alloc_);
     }
 }
 
 /// assign from map<string, long long>
+template <typename Allocator>
 template<template <typename...> class Container, typename...Args, detail::enable_if_str_ll_map_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<std::string, long long, Args...>& map, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<std::string, long long, Args...>& map, bool str_copy)
 {
     value_.SetObject();
     for (auto& k : map){
-        rapidjson::Value name;
+        Value name;
         if ( str_copy ) {
             name.SetString(k.first.data(), k.first.length(), alloc_);
         } else {
             name.SetString(k.first.data(), k.first.length());
         }
-        rapidjson::Value value(static_cast<int64_t>(k.second));
+        Value value(static_cast<int64_t>(k.second));
         value_.AddMember(name.Move(), value.Move(), alloc_);
     }
 }
 
 /// assign from map<string, unsigned long long>
+template <typename Allocator>
 template<template <typename...> class Container, typename...Args, detail::enable_if_str_ull_map_t<Container, Args...>*>
-inline void ValueRef::set_container(const Container<std::string, unsigned long long, Args...>& map, bool str_copy)
+inline void BasicValueRef<Allocator>::set_container(const Container<std::string, unsigned long long, Args...>& map, bool str_copy)
 {
     value_.SetObject();
     for (auto& k : map){
-        rapidjson::Value name;
+        Value name;
         if ( str_copy ) {
             name.SetString(k.first.data(), k.first.length(), alloc_);
         } else {
             name.SetString(k.first.data(), k.first.length());
         }
-        rapidjson::Value value(static_cast<uint64_t>(k.second));
+        Value value(static_cast<uint64_t>(k.second));
         value_.AddMember(name.Move(), value.Move(), alloc_);
     }
 }
@@ -516,18 +672,21 @@ inline void ValueRef::set_container(const Container<std::string, unsigned long l
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// Member Reference for ObjectIterator
 /////////////////////////////////////////////////////////////////////////////////////////////
-struct MemberRef {
-    MemberRef(rapidjson::Value::Member& ref, rapidjson::Document::AllocatorType& allocator)
-        : name(ref.name, allocator), value(ref.value, allocator) {}
-    MemberRef(const MemberRef& rfs)
+template <typename Allocator>
+struct BasicMemberRef {
+    using ValueRef = BasicValueRef<Allocator>;
+
+    BasicMemberRef(typename ValueRef::Value::Member& ref, Allocator& allocator, const std::shared_ptr<void>* source)
+        : name(ref.name, allocator, source), value(ref.value, allocator, source) {}
+    BasicMemberRef(const BasicMemberRef& rfs)
         : name(rfs.name), value(rfs.value) {}
-    ~MemberRef() {}
+    ~BasicMemberRef() {}
 
-    MemberRef& operator=(const MemberRef& other){
+    BasicMemberRef& operator=(const BasicMemberRef& other){
         name = other.name; value = other.value; // copy name and value from other to this
         return *this;
     }
-    MemberRef* operator->() { return this; } // needed by MemberIterator
+    BasicMemberRef* operator->() { return this; } // needed by MemberIterator
 
     ValueRef name;
     ValueRef value;
@@ -536,10 +695,12 @@ struct MemberRef {
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// ArrayRef ( Reference Value for array )
 /////////////////////////////////////////////////////////////////////////////////////////////
-inline ArrayRef::ArrayRef(const ArrayRef& rfs)
+template <typename Allocator>
+inline BasicArrayRef<Allocator>::BasicArrayRef(const ArrayRef& rfs)
     : valueRef_(rfs.valueRef_) {}
 
-inline ArrayRef::ArrayRef(const ValueRef& value)
+template <typename Allocator>
+inline BasicArrayRef<Allocator>::BasicArrayRef(const ValueRef& value)
     : valueRef_(value)
 {
     if ( valueRef_.value_.IsNull() ) {
@@ -549,50 +710,58 @@ inline ArrayRef::ArrayRef(const ValueRef& value)
     }
 }
 
+template <typename Allocator>
 template<typename T, template <typename...> class Container, typename...Args,
     detail::enable_if_sequence_t<T, Container, Args...>*
 >
-inline ArrayRef& ArrayRef::operator=(const Container<T, Args...>& array) {
+inline BasicArrayRef<Allocator>& BasicArrayRef<Allocator>::operator=(const Container<T, Args...>& array) {
     valueRef_.set_container(array);
     return *this;
 }
 
+template <typename Allocator>
 template<typename T, template <typename...> class Container, typename...Args,
     detail::enable_if_sequence_t<T, Container, Args...>*
 >
-inline void ArrayRef::set_container(const Container<T, Args...>& array, bool str_copy) {
+inline void BasicArrayRef<Allocator>::set_container(const Container<T, Args...>& array, bool str_copy) {
     valueRef_.set_container(array, str_copy);
 }
 
-inline ValueRef ArrayRef::operator[](size_t index) const {
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicArrayRef<Allocator>::operator[](size_t index) const {
     if ( index >= valueRef_.value_.Size() ) {
         throw std::runtime_error("Array index out_of_range");
     }
-    return ValueRef(valueRef_.value_[index], valueRef_.alloc_);
+    return ValueRef(valueRef_.value_[index], valueRef_.alloc_, valueRef_.source_);
 }
 
-inline size_t ArrayRef::size() const {
+template <typename Allocator>
+inline size_t BasicArrayRef<Allocator>::size() const {
     return valueRef_.value_.Size();
 }
 
-inline bool ArrayRef::empty() const {
+template <typename Allocator>
+inline bool BasicArrayRef<Allocator>::empty() const {
     return valueRef_.value_.Empty();
 }
 
-inline size_t ArrayRef::capacity() const {
+template <typename Allocator>
+inline size_t BasicArrayRef<Allocator>::capacity() const {
     return valueRef_.value_.Capacity();
 }
 
-inline void ArrayRef::reserve(size_t n) {
+template <typename Allocator>
+inline void BasicArrayRef<Allocator>::reserve(size_t n) {
     valueRef_.value_.Reserve(n, valueRef_.alloc_);
 }
 
-inline void ArrayRef::resize(size_t n) {
+template <typename Allocator>
+inline void BasicArrayRef<Allocator>::resize(size_t n) {
     int diff = n - size();
     reserve(n);
     if (diff > 0) {
         for (int i = 0; i < diff; ++i) {
-            valueRef_.value_.PushBack(rapidjson::Value(), valueRef_.alloc_);
+            valueRef_.value_.PushBack(Value(), valueRef_.alloc_);
         }
     } else if (diff < 0) {
         diff *= -1;
@@ -602,14 +771,15 @@ inline void ArrayRef::resize(size_t n) {
     }
 }
 
+template <typename Allocator>
 template <typename T>
-inline void ArrayRef::resize(size_t n, T&& value) {
+inline void BasicArrayRef<Allocator>::resize(size_t n, T&& value) {
     int diff = n - size();
     reserve(n);
     if (diff > 0) {
         for (int i = 0; i < diff; ++i) {
-            rapidjson::Value temp;
-            ValueRef dummy(temp, valueRef_.alloc_);
+            Value temp;
+            ValueRef dummy(temp, valueRef_.alloc_, valueRef_.source_);
             dummy = std::forward<T>(value);
             valueRef_.value_.PushBack(temp.Move(), valueRef_.alloc_);
         }
@@ -621,41 +791,47 @@ inline void ArrayRef::resize(size_t n, T&& value) {
     }
 }
 
-inline void ArrayRef::clear() {
+template <typename Allocator>
+inline void BasicArrayRef<Allocator>::clear() {
     valueRef_.value_.Clear();
 }
 
-inline ValueIterator ArrayRef::begin() const {
-    return ValueIterator(valueRef_.value_.Begin(), valueRef_.alloc_);
+template <typename Allocator>
+inline BasicValueIterator<Allocator> BasicArrayRef<Allocator>::begin() const {
+    return ValueIterator(valueRef_.value_.Begin(), valueRef_.alloc_, valueRef_.source_);
 }
 
-inline ValueIterator ArrayRef::end() const {
-    return ValueIterator(valueRef_.value_.End(), valueRef_.alloc_);
+template <typename Allocator>
+inline BasicValueIterator<Allocator> BasicArrayRef<Allocator>::end() const {
+    return ValueIterator(valueRef_.value_.End(), valueRef_.alloc_, valueRef_.source_);
 }
 
-inline ValueRef ArrayRef::front() const {
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicArrayRef<Allocator>::front() const {
     if ( valueRef_.value_.Empty() ) {
         throw std::runtime_error("Empty Array front() is null");
     }
-    return ValueRef(valueRef_.value_[0], valueRef_.alloc_);
+    return ValueRef(valueRef_.value_[0], valueRef_.alloc_, valueRef_.source_);
 }
 
-inline ValueRef ArrayRef::back() const {
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicArrayRef<Allocator>::back() const {
     if ( valueRef_.value_.Empty() ) {
         throw std::runtime_error("Empty Array back() is null");
     }
-    return ValueRef(valueRef_.value_[size()-1], valueRef_.alloc_);
+    return ValueRef(valueRef_.value_[size()-1], valueRef_.alloc_, valueRef_.source_);
 }
 
+template <typename Allocator>
 template <typename T>
-inline optional<std::vector<T>> ArrayRef::get_vector()
+inline optional<std::vector<T>> BasicArrayRef<Allocator>::get_vector()
 {
     optional<std::vector<T>> result;
     std::vector<T> res;
     res.reserve(size());
     for (const auto& value : *this)
     {
-        auto value_ = value.get<T>();
+        auto value_ = value.template get<T>();
         if ( value_ ) {
             res.emplace_back(std::move(*value_));
         } else {
@@ -666,14 +842,15 @@ inline optional<std::vector<T>> ArrayRef::get_vector()
     return result;
 }
 
+template <typename Allocator>
 template <typename T>
-inline std::vector<T> ArrayRef::as_vector(std::function<bool(const T&)> func)
+inline std::vector<T> BasicArrayRef<Allocator>::as_vector(std::function<bool(const T&)> func)
 {
     std::vector<T> result;
     result.reserve(size());
     for (const auto& value : *this)
     {
-        T value_ = value.as<T>();
+        T value_ = value.template as<T>();
         if ( func(value_) ) {
             result.emplace_back(std::move(value_));
         }
@@ -681,38 +858,45 @@ inline std::vector<T> ArrayRef::as_vector(std::function<bool(const T&)> func)
     return result;
 }
 
+template <typename Allocator>
 template<typename T>
-inline void ArrayRef::push_back(T&& value) {
-    rapidjson::Value temp;
-    ValueRef dummy(temp, valueRef_.alloc_);
+inline void BasicArrayRef<Allocator>::push_back(T&& value) {
+    Value temp;
+    ValueRef dummy(temp, valueRef_.alloc_, valueRef_.source_);
     dummy = std::forward<T>(value);
     valueRef_.value_.PushBack(temp.Move(), valueRef_.alloc_);
 }
 
-inline ValueRef ArrayRef::push_back() {
-    valueRef_.value_.PushBack(rapidjson::Value(), valueRef_.alloc_);
-    return ValueRef(valueRef_.value_[size()-1], valueRef_.alloc_);
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicArrayRef<Allocator>::push_back() {
+    valueRef_.value_.PushBack(Value(), valueRef_.alloc_);
+    return ValueRef(valueRef_.value_[size()-1], valueRef_.alloc_, valueRef_.source_);
 }
 
-inline void ArrayRef::pop_back() {
+template <typename Allocator>
+inline void BasicArrayRef<Allocator>::pop_back() {
     if ( not valueRef_.value_.Empty() ) {
         valueRef_.value_.PopBack();
     }
 }
 
-inline ValueIterator ArrayRef::erase(const ValueIterator& pos) {
-    return ValueIterator(valueRef_.value_.Erase(pos.ptr_), valueRef_.alloc_);
+template <typename Allocator>
+inline BasicValueIterator<Allocator> BasicArrayRef<Allocator>::erase(const ValueIterator& pos) {
+    return ValueIterator(valueRef_.value_.Erase(pos.ptr_), valueRef_.alloc_, valueRef_.source_);
 }
 
-inline ValueIterator ArrayRef::erase(const ValueIterator& first, const ValueIterator& last) {
-    return ValueIterator(valueRef_.value_.Erase(first.ptr_, last.ptr_), valueRef_.alloc_);
+template <typename Allocator>
+inline BasicValueIterator<Allocator> BasicArrayRef<Allocator>::erase(const ValueIterator& first, const ValueIterator& last) {
+    return ValueIterator(valueRef_.value_.Erase(first.ptr_, last.ptr_), valueRef_.alloc_, valueRef_.source_);
 }
 
-inline ValueRef ArrayRef::get_value_ref() const {
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicArrayRef<Allocator>::get_value_ref() const {
     return valueRef_;
 }
 
-inline ObjectRef::ObjectRef(const ValueRef& value)
+template <typename Allocator>
+inline BasicObjectRef<Allocator>::BasicObjectRef(const ValueRef& value)
     : valueRef_(value)
 {
     static const size_t STRING_MAX_SIZE = 15;
@@ -723,156 +907,180 @@ inline ObjectRef::ObjectRef(const ValueRef& value)
     }
 }
 
-inline ObjectRef::ObjectRef(const ObjectRef& rfs)
+template <typename Allocator>
+inline BasicObjectRef<Allocator>::BasicObjectRef(const ObjectRef& rfs)
     : valueRef_(rfs.valueRef_)
 {}
 
+template <typename Allocator>
 template<typename T, template <typename...> class Container, typename...Args,
     detail::enable_if_strmap_t<T, Container>*
 >
-inline ObjectRef& ObjectRef::operator=(const Container<std::string, T, Args...>& map) {
+inline BasicObjectRef<Allocator>& BasicObjectRef<Allocator>::operator=(const Container<std::string, T, Args...>& map) {
     valueRef_.set_container(map);
     return *this;
 }
 
 /// set_container map<std::string, T>
+template <typename Allocator>
 template<typename T, template <typename...> class Container, typename...Args,
     detail::enable_if_strmap_t<T, Container>*
 >
-inline void ObjectRef::set_container(const Container<std::string, T, Args...>& map, bool str_copy) {
+inline void BasicObjectRef<Allocator>::set_container(const Container<std::string, T, Args...>& map, bool str_copy) {
     valueRef_.set_container(map, str_copy);
 }
 
-inline ValueRef ObjectRef::operator[](const std::string& name) const {
-    rapidjson::Value key(name.data(), name.length());
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicObjectRef<Allocator>::operator[](const std::string& name) const {
+    Value key(name.data(), name.length());
     auto it = valueRef_.value_.FindMember(key);
     if (it == valueRef_.value_.MemberEnd()){
-        valueRef_.value_.AddMember(rapidjson::Value(name.data(), name.length(), valueRef_.alloc_), rapidjson::Value(), valueRef_.alloc_);
+        valueRef_.value_.AddMember(Value(name.data(), name.length(), valueRef_.alloc_), Value(), valueRef_.alloc_);
         it = valueRef_.value_.MemberEnd()-1;
     }
-    return ValueRef(it->value, valueRef_.alloc_);
+    return ValueRef(it->value, valueRef_.alloc_, valueRef_.source_);
 }
 
-inline ValueRef ObjectRef::operator[](const char* name) const {
-    rapidjson::Value key(rapidjson::StringRef(name));
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicObjectRef<Allocator>::operator[](const char* name) const {
+    Value key(rapidjson::StringRef(name));
     auto it = valueRef_.value_.FindMember(key);
     if (it == valueRef_.value_.MemberEnd()) {
-        valueRef_.value_.AddMember(rapidjson::Value(rapidjson::StringRef(name), valueRef_.alloc_), rapidjson::Value(), valueRef_.alloc_);
+        valueRef_.value_.AddMember(Value(rapidjson::StringRef(name), valueRef_.alloc_), Value(), valueRef_.alloc_);
         it = valueRef_.value_.MemberEnd()-1;
     }
-    return ValueRef(it->value, valueRef_.alloc_);
+    return ValueRef(it->value, valueRef_.alloc_, valueRef_.source_);
 }
 
-inline ValueRef ObjectRef::operator[](const string_view& name) const {
-    rapidjson::Value key(rapidjson::StringRef(name.data(), name.length()));
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicObjectRef<Allocator>::operator[](const string_view& name) const {
+    Value key(rapidjson::StringRef(name.data(), name.length()));
     auto it = valueRef_.value_.FindMember(key);
     if (it == valueRef_.value_.MemberEnd()) {
-        valueRef_.value_.AddMember(rapidjson::Value(rapidjson::StringRef(name.data(), name.length())), rapidjson::Value(), valueRef_.alloc_);
+        valueRef_.value_.AddMember(Value(rapidjson::StringRef(name.data(), name.length())), Value(), valueRef_.alloc_);
         it = valueRef_.value_.MemberEnd()-1;
     }
-    return ValueRef(it->value, valueRef_.alloc_);
+    return ValueRef(it->value, valueRef_.alloc_, valueRef_.source_);
 }
 
-inline optional<ValueRef> ObjectRef::find(const std::string& name) const {
+template <typename Allocator>
+inline optional<BasicValueRef<Allocator>> BasicObjectRef<Allocator>::find(const std::string& name) const {
     optional<ValueRef> ret;
-    rapidjson::Value key(name.data(), name.length());
+    Value key(name.data(), name.length());
     auto it = valueRef_.value_.FindMember(key);
     if ( it != valueRef_.value_.MemberEnd() ) {
-        ret = ValueRef(it->value, valueRef_.alloc_);
+        ret = ValueRef(it->value, valueRef_.alloc_, valueRef_.source_);
     }
     return ret;
 }
 
-inline int ObjectRef::count(const std::string& name) const {
-    rapidjson::Value key(name.data(), name.length());
+template <typename Allocator>
+inline int BasicObjectRef<Allocator>::count(const std::string& name) const {
+    Value key(name.data(), name.length());
     auto it = valueRef_.value_.FindMember(key);
     return (it != valueRef_.value_.MemberEnd());
 }
 
-inline size_t ObjectRef::size() const {
+template <typename Allocator>
+inline size_t BasicObjectRef<Allocator>::size() const {
     return valueRef_.value_.MemberCount();
 }
 
-inline bool ObjectRef::empty() const {
+template <typename Allocator>
+inline bool BasicObjectRef<Allocator>::empty() const {
     return valueRef_.value_.ObjectEmpty();
 }
 
-inline bool ObjectRef::has(const std::string& name) const {
+template <typename Allocator>
+inline bool BasicObjectRef<Allocator>::has(const std::string& name) const {
     return valueRef_.value_.HasMember(name.c_str());
 }
 
-inline void ObjectRef::clear() {
+template <typename Allocator>
+inline void BasicObjectRef<Allocator>::clear() {
     return valueRef_.value_.RemoveAllMembers();
 }
 
-inline MemberIterator ObjectRef::begin() const {
-    return MemberIterator(valueRef_.value_.MemberBegin(), valueRef_.alloc_);
+template <typename Allocator>
+inline BasicMemberIterator<Allocator> BasicObjectRef<Allocator>::begin() const {
+    return MemberIterator(valueRef_.value_.MemberBegin(), valueRef_.alloc_, valueRef_.source_);
 }
 
-inline MemberIterator ObjectRef::end() const {
-    return MemberIterator(valueRef_.value_.MemberEnd(), valueRef_.alloc_);
+template <typename Allocator>
+inline BasicMemberIterator<Allocator> BasicObjectRef<Allocator>::end() const {
+    return MemberIterator(valueRef_.value_.MemberEnd(), valueRef_.alloc_, valueRef_.source_);
 }
 
+template <typename Allocator>
 template<typename T>
-inline void ObjectRef::insert(const char* name, T&& value) {          // key copy
-    rapidjson::Value temp;
-    ValueRef dummy(temp, valueRef_.alloc_);
+inline void BasicObjectRef<Allocator>::insert(const char* name, T&& value) {          // key copy
+    Value temp;
+    ValueRef dummy(temp, valueRef_.alloc_, valueRef_.source_);
     dummy = std::forward<T>(value);
-    valueRef_.value_.AddMember(rapidjson::Value(name, strlen(name), valueRef_.alloc_), temp.Move(), valueRef_.alloc_);
+    valueRef_.value_.AddMember(Value(name, strlen(name), valueRef_.alloc_), temp.Move(), valueRef_.alloc_);
 }
 
+template <typename Allocator>
 template<typename T>
-inline void ObjectRef::insert(const std::string& name, T&& value) {
-    rapidjson::Value temp;
-    ValueRef dummy(temp, valueRef_.alloc_);
+inline void BasicObjectRef<Allocator>::insert(const std::string& name, T&& value) {
+    Value temp;
+    ValueRef dummy(temp, valueRef_.alloc_, valueRef_.source_);
     dummy = std::forward<T>(value);
-    valueRef_.value_.AddMember(rapidjson::Value(name.data(), name.length(), valueRef_.alloc_), temp.Move(), valueRef_.alloc_);
+    valueRef_.value_.AddMember(Value(name.data(), name.length(), valueRef_.alloc_), temp.Move(), valueRef_.alloc_);
 }
 
+template <typename Allocator>
 template<typename T>
-inline void ObjectRef::insert(const string_view& name, T&& value) {
-    rapidjson::Value temp;
-    ValueRef dummy(temp, valueRef_.alloc_);
+inline void BasicObjectRef<Allocator>::insert(const string_view& name, T&& value) {
+    Value temp;
+    ValueRef dummy(temp, valueRef_.alloc_, valueRef_.source_);
     dummy = std::forward<T>(value);
-    valueRef_.value_.AddMember(rapidjson::Value(name.data(), name.length()), temp.Move(), valueRef_.alloc_);
+    valueRef_.value_.AddMember(Value(name.data(), name.length()), temp.Move(), valueRef_.alloc_);
 }
 
-inline ValueRef ObjectRef::insert(const char* name) {
-    valueRef_.value_.AddMember(rapidjson::Value(name, strlen(name), valueRef_.alloc_), rapidjson::Value(), valueRef_.alloc_);
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicObjectRef<Allocator>::insert(const char* name) {
+    valueRef_.value_.AddMember(Value(name, strlen(name), valueRef_.alloc_), Value(), valueRef_.alloc_);
     auto it = (valueRef_.value_.MemberEnd() - 1);
-    return ValueRef(it->value, valueRef_.alloc_);
+    return ValueRef(it->value, valueRef_.alloc_, valueRef_.source_);
 }
 
-inline ValueRef ObjectRef::insert(const std::string& name) {
-    valueRef_.value_.AddMember(rapidjson::Value(name.data(), name.length(), valueRef_.alloc_), rapidjson::Value(), valueRef_.alloc_);
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicObjectRef<Allocator>::insert(const std::string& name) {
+    valueRef_.value_.AddMember(Value(name.data(), name.length(), valueRef_.alloc_), Value(), valueRef_.alloc_);
     auto it = (valueRef_.value_.MemberEnd() - 1);
-    return ValueRef(it->value, valueRef_.alloc_);
+    return ValueRef(it->value, valueRef_.alloc_, valueRef_.source_);
 }
 
-inline ValueRef ObjectRef::insert(const string_view& name) {
-    valueRef_.value_.AddMember(rapidjson::Value(name.data(), name.length()), rapidjson::Value(), valueRef_.alloc_);
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicObjectRef<Allocator>::insert(const string_view& name) {
+    valueRef_.value_.AddMember(Value(name.data(), name.length()), Value(), valueRef_.alloc_);
     auto it = (valueRef_.value_.MemberEnd() - 1);
-    return ValueRef(it->value, valueRef_.alloc_);
+    return ValueRef(it->value, valueRef_.alloc_, valueRef_.source_);
 }
 
-inline MemberIterator ObjectRef::erase(const std::string& name)  {
-    auto it = valueRef_.value_.FindMember(rapidjson::Value(name.data(), name.length()));
+template <typename Allocator>
+inline BasicMemberIterator<Allocator> BasicObjectRef<Allocator>::erase(const std::string& name)  {
+    auto it = valueRef_.value_.FindMember(Value(name.data(), name.length()));
     if (it != valueRef_.value_.MemberEnd()) {
-        return MemberIterator(valueRef_.value_.EraseMember(it), valueRef_.alloc_);
+        return MemberIterator(valueRef_.value_.EraseMember(it), valueRef_.alloc_, valueRef_.source_);
     } else {
-        return MemberIterator(it, valueRef_.alloc_);
+        return MemberIterator(it, valueRef_.alloc_, valueRef_.source_);
     }
 }
 
-inline MemberIterator ObjectRef::erase(const MemberIterator& pos) {
-    return MemberIterator(valueRef_.value_.EraseMember(pos.ptr_), valueRef_.alloc_);
+template <typename Allocator>
+inline BasicMemberIterator<Allocator> BasicObjectRef<Allocator>::erase(const MemberIterator& pos) {
+    return MemberIterator(valueRef_.value_.EraseMember(pos.ptr_), valueRef_.alloc_, valueRef_.source_);
 }
 
-inline MemberIterator ObjectRef::erase(const MemberIterator& first, const MemberIterator& last) {
-    return MemberIterator(valueRef_.value_.EraseMember(first.ptr_, last.ptr_), valueRef_.alloc_);
+template <typename Allocator>
+inline BasicMemberIterator<Allocator> BasicObjectRef<Allocator>::erase(const MemberIterator& first, const MemberIterator& last) {
+    return MemberIterator(valueRef_.value_.EraseMember(first.ptr_, last.ptr_), valueRef_.alloc_, valueRef_.source_);
 }
 
-inline ValueRef ObjectRef::get_value_ref() const {
+template <typename Allocator>
+inline BasicValueRef<Allocator> BasicObjectRef<Allocator>::get_value_ref() const {
     return valueRef_;
 }
 
@@ -880,8 +1088,9 @@ inline ValueRef ObjectRef::get_value_ref() const {
 /// ObjectRef::get tempalte impl
 /////////////////////////////////////////////////////////////////////////////////////////////
 
+template <typename Allocator>
 template<typename T>
-inline T ObjectRef::get_value(const std::string& name, const T& defval) const {
+inline T BasicObjectRef<Allocator>::get_value(const std::string& name, const T& defval) const {
     optional<T> value = get_value<T>(name);
     if ( not value ) {
         value = defval;
@@ -889,34 +1098,37 @@ inline T ObjectRef::get_value(const std::string& name, const T& defval) const {
     return *value;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_str_t<T>*>
-inline optional<std::string> ObjectRef::get_value(const std::string& name) const {
+inline optional<std::string> BasicObjectRef<Allocator>::get_value(const std::string& name) const {
     optional<std::string> ret;
-    rapidjson::Value key(name.data(), name.length());
+    Value key(name.data(), name.length());
     auto it = valueRef_.value_.FindMember(key);
-    if ( it != valueRef_.value_.MemberEnd() and it->value.IsString()) {
-        ret = std::string(it->value.GetString(), it->value.GetStringLength());
+    if ( it != valueRef_.value_.MemberEnd() ) {
+        ret = ValueRef(it->value, valueRef_.alloc_, valueRef_.source_).template get<std::string>();
     }
     return ret;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_cptr_t<T>*>
-inline optional<const char*> ObjectRef::get_value(const std::string& name) const {
+inline optional<const char*> BasicObjectRef<Allocator>::get_value(const std::string& name) const {
     optional<const char*> ret;
-    rapidjson::Value key(name.data(), name.length());
+    Value key(name.data(), name.length());
     auto it = valueRef_.value_.FindMember(key);
-    if ( it != valueRef_.value_.MemberEnd() and it->value.IsString()) {
-        ret = it->value.GetString();
+    if ( it != valueRef_.value_.MemberEnd() ) {
+        ret = ValueRef(it->value, valueRef_.alloc_, valueRef_.source_).template get<const char*>();
     }
     return ret;
 }
 
+template <typename Allocator>
 template<typename T, detail::enable_if_num_t<T>*>
-inline optional<T> ObjectRef::get_value(const std::string& name) const {
-    rapidjson::Value key(name.data(), name.length());
+inline optional<T> BasicObjectRef<Allocator>::get_value(const std::string& name) const {
+    Value key(name.data(), name.length());
     auto it = valueRef_.value_.FindMember(key);
     if ( it != valueRef_.value_.MemberEnd() ) {
-        return ValueRef(it->value, valueRef_.alloc_).get<T>();
+        return ValueRef(it->value, valueRef_.alloc_, valueRef_.source_).template get<T>();
     }
     return optional<T>();
 }
@@ -925,23 +1137,25 @@ inline optional<T> ObjectRef::get_value(const std::string& name) const {
 /////////////////////////////////////////////////////////////////////////////////////////////
 /// ValueRef::find_xxx tempalte impl
 /////////////////////////////////////////////////////////////////////////////////////////////
+template <typename Allocator>
 template<template <typename...> class Container, typename...Args, detail::enable_if_sequence_t<std::string, Container, Args...>*>
-inline MemberIterator ObjectRef::find_any(Container<std::string> names) const
+inline BasicMemberIterator<Allocator> BasicObjectRef<Allocator>::find_any(Container<std::string> names) const
 {
     for ( const auto& name : names ) {
-        auto it = valueRef_.value_.FindMember(rapidjson::Value(name.data(), name.length()));
+        auto it = valueRef_.value_.FindMember(Value(name.data(), name.length()));
         if (it != valueRef_.value_.MemberEnd()) {
-            return MemberIterator(it, valueRef_.alloc_);
+            return MemberIterator(it, valueRef_.alloc_, valueRef_.source_);
         }
     }
-    return MemberIterator(valueRef_.value_.MemberEnd(), valueRef_.alloc_);
+    return MemberIterator(valueRef_.value_.MemberEnd(), valueRef_.alloc_, valueRef_.source_);
 }
 
+template <typename Allocator>
 template<template <typename...> class Container, typename...Args, detail::enable_if_sequence_t<std::string, Container, Args...>*>
-inline bool ObjectRef::find_all(Container<std::string> names) const
+inline bool BasicObjectRef<Allocator>::find_all(Container<std::string> names) const
 {
     for ( const auto& name : names ) {
-        auto it = valueRef_.value_.FindMember(rapidjson::Value(name.data(), name.length()));
+        auto it = valueRef_.value_.FindMember(Value(name.data(), name.length()));
         if (it == valueRef_.value_.MemberEnd()) {
             return false;
         }